@@ -0,0 +1,131 @@
+// Benchmark: heap allocations and time of making moves on board copies vs. in
+// place (Board::apply/undo), and allocations per node of the search players.
+// Usage: benchAllocations [search depth]
+//
+
+#include "positions.h"
+
+#include "eval.h"
+#include "game_context.h"
+#include "minimax_player.h"
+
+#include <tbb/task_scheduler_init.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+using namespace grandeur;
+using namespace std;
+
+// Count every heap allocation in the program:
+static atomic<uint64_t> g_allocs(0);
+
+void* operator new(size_t size)
+{
+    ++g_allocs;
+    if (void* ret = malloc(size ? size : 1)) {
+        return ret;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+
+
+static const auto allEval =
+        combine({ winCondition, countPoints, countPrestige, countGems, countMoves,
+                  monopolizeGems, preferWildcards, countReturns, preferShortGame, preferBuyTowardNoble },
+                { 100, 2, 1, 1, 0, 0, 0, -1, 1, 2 });
+
+
+static void
+report(const char* name, uint64_t allocs, uint64_t count, double secs, const char* unit)
+{
+    cout << setw(24) << name << setw(12) << fixed << setprecision(2) << double(allocs) / count
+         << " allocs/" << unit << setw(12) << setprecision(1) << 1e9 * secs / count
+         << " ns/" << unit << endl;
+}
+
+
+// Make every legal move of every board, either on a fresh copy of the board
+// (the way computeScores used to), or in place and then undo it:
+static void
+makeMoves(const vector<Board>& boards, unsigned reps)
+{
+    uint64_t nmoves = 0;
+    auto allocs = g_allocs.load();
+    bench::Timer copyTimer;
+    for (unsigned r = 0; r < reps; ++r) {
+        for (unsigned i = 0; i < boards.size(); ++i) {
+            const auto legal = legalMoves(boards[i], i % 2);
+            vector<Board> newBoards;
+            for (const auto& mv : legal) {
+                newBoards.push_back(boards[i]);
+                makeMove(newBoards.back(), i % 2, mv);
+            }
+            nmoves += legal.size();
+        }
+    }
+    report("copy + makeMove", g_allocs - allocs, nmoves, copyTimer.seconds(), "move");
+
+    nmoves = 0;
+    allocs = g_allocs.load();
+    bench::Timer applyTimer;
+    for (unsigned r = 0; r < reps; ++r) {
+        for (unsigned i = 0; i < boards.size(); ++i) {
+            const auto legal = legalMoves(boards[i], i % 2);
+            Board board = boards[i];
+            for (const auto& mv : legal) {
+                const auto undo = board.apply(i % 2, mv);
+                board.undo(undo);
+            }
+            nmoves += legal.size();
+        }
+    }
+    report("apply + undo", g_allocs - allocs, nmoves, applyTimer.seconds(), "move");
+}
+
+
+template <class SearchPlayer>
+static void
+search(const char* name, unsigned depth, const vector<Board>& boards)
+{
+    uint64_t nodes = 0;
+    double secs = 0;
+    const auto allocs = g_allocs.load();
+    for (unsigned i = 0; i < boards.size(); ++i) {
+        const player_id_t pid = i % 2;
+        const auto legal = legalMoves(boards[i], pid);
+        if (legal.empty()) {
+            continue;
+        }
+        GameContext context(i);
+        const SearchPlayer player(depth, allEval, pid, 0.01, 0);
+        bench::Timer timer;
+        player.getMove(boards[i], legal, context);
+        secs += timer.seconds();
+        nodes += player.nodesVisited();
+    }
+    report(name, g_allocs - allocs, nodes, secs, "node");
+}
+
+
+int main(int argc, char** argv)
+{
+    const unsigned depth = (argc > 1)? atoi(argv[1]) : 3;
+    tbb::task_scheduler_init init;
+
+    const auto boards = bench::randomBoards(2, 3, 10);
+    cout << "Making moves on " << boards.size() << " boards\n";
+    makeMoves(boards, 20);
+
+    cout << "Searching at depth " << depth << " (no transposition table)\n";
+    search<MinimaxPlayer>("minimax", depth, boards);
+    search<AlphaBetaPlayer>("alphabeta", depth, boards);
+
+    return 0;
+}
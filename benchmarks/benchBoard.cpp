@@ -0,0 +1,85 @@
+// Benchmark: the cost of copying a Board, the throughput of legalMoves(), the
+// cost of buying and reserving cards, and of checking whether the game is over,
+// with the no. of players at run time (Board) and at compile time (FixedBoard).
+// Usage: benchBoard [repetitions]
+//
+
+#include "positions.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace grandeur;
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    const unsigned reps = (argc > 1)? atoi(argv[1]) : 20000;
+    const auto boards = bench::randomBoards(2, 3, 10);
+    const auto nboards = boards.size();
+    cout << "sizeof(Board) = " << sizeof(Board) << " bytes, " << nboards << " boards\n";
+
+    // Copy each board into a vector of boards, the way computeScores does:
+    vector<Board> copies;
+    unsigned long checksum = 0;
+    bench::Timer copyTimer;
+    for (unsigned r = 0; r < reps; ++r) {
+        copies.clear();
+        for (const auto& board : boards) {
+            copies.push_back(board);
+        }
+        checksum += copies[r % nboards].playerPoints(0);
+    }
+    const auto copySecs = copyTimer.seconds();
+    cout << "Board copy:  " << fixed << setprecision(1)
+         << 1e9 * copySecs / (reps * nboards) << " ns/copy\n";
+
+    unsigned long nmoves = 0;
+    bench::Timer movesTimer;
+    for (unsigned r = 0; r < reps; ++r) {
+        for (unsigned i = 0; i < nboards; ++i) {
+            nmoves += legalMoves(boards[i], (i + r) % 2).size();
+        }
+    }
+    const auto movesSecs = movesTimer.seconds();
+    cout << "legalMoves:  " << 1e9 * movesSecs / (reps * nboards) << " ns/call, "
+         << setprecision(2) << 1e-6 * nmoves / movesSecs << " M moves/sec\n";
+
+    // Buy and reserve every card possible (in place, and undone right away):
+    auto scratch = boards;
+    unsigned long ncards = 0;
+    bench::Timer cardsTimer;
+    for (unsigned r = 0; r < reps; ++r) {
+        for (unsigned i = 0; i < nboards; ++i) {
+            const player_id_t pid = (i + r) % 2;
+            for (const auto& mv : legalMoves(boards[i], pid)) {
+                if (mv.type() != TAKE_GEMS) {
+                    scratch[i].undo(scratch[i].apply(pid, mv));
+                    ++ncards;
+                }
+            }
+        }
+    }
+    const auto cardsSecs = cardsTimer.seconds() - movesSecs;  // Without the legalMoves calls
+    cout << "Buy/reserve: " << setprecision(1) << 1e9 * cardsSecs / ncards << " ns/move (apply + undo)\n";
+
+    // The game loops check for the end of the game once a round:
+    const vector<FixedBoard<2>> fixedBoards(boards.cbegin(), boards.cend());
+    unsigned long nover = 0;
+    bench::Timer overTimer;
+    for (unsigned r = 0; r < 50 * reps; ++r) {
+        nover += boards[r % nboards].gameOver();
+    }
+    const auto overSecs = overTimer.seconds();
+    bench::Timer fixedTimer;
+    for (unsigned r = 0; r < 50 * reps; ++r) {
+        nover += fixedBoards[r % nboards].gameOver();
+    }
+    const auto fixedSecs = fixedTimer.seconds();
+    cout << "gameOver:    " << 1e9 * overSecs / (50 * reps) << " ns/call (Board), "
+         << 1e9 * fixedSecs / (50 * reps) << " ns/call (FixedBoard<2>)\n";
+    checksum += nover;
+
+    return (checksum == 0xFFFFFFFF);  // Keep the copies from being optimized away
+}
@@ -0,0 +1,111 @@
+// Benchmark: the same weighted evaluation, computed three ways: as a sum of
+// separate std::function evaluators, as one batch of feature arrays (what
+// combine() returns for the evaluation functions), and fused at compile time.
+// Reports the cost of scoring the moves of a board, and the node rate of
+// alpha-beta searches that use each evaluator.
+// Usage: benchEval [alphabeta depth] [repetitions]
+//
+
+#include "positions.h"
+
+#include "eval.h"
+#include "fused_eval.h"
+#include "game_context.h"
+#include "minimax_player.h"
+
+#include <tbb/task_scheduler_init.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace grandeur;
+using namespace std;
+
+// Hide an evaluation function from combine(), so it can only call it through std::function:
+static evaluator_t
+erased(const evaluator_t& eval)
+{
+    return [eval](const Moves& moves, player_id_t pid, const Board& board, const vector<Board>& newBoards) {
+        return eval(moves, pid, board, newBoards);
+    };
+}
+
+static const vector<score_t> weights = { 100, 2, 1, 1, -1, 1, 2 };
+
+static const auto separateEval =
+        combine({ erased(winCondition), erased(countPoints), erased(countPrestige), erased(countGems),
+                  erased(countReturns), erased(preferShortGame), erased(preferBuyTowardNoble) }, weights);
+
+static const auto batchedEval =
+        combine({ winCondition, countPoints, countPrestige, countGems,
+                  countReturns, preferShortGame, preferBuyTowardNoble }, weights);
+
+static const evaluator_t fusedEval =
+        FusedEvaluator<Term<WINS, 100>, Term<POINT_GAIN, 2>, Term<PRESTIGE_GAIN, 1>, Term<GEM_GAIN, 1>,
+                       Term<RETURNS, -1>, Term<GAME_LENGTH, 1>, Term<NOBLE_PROGRESS, 2>>();
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Score the moves of every board, and then search every board with alpha-beta:
+static void
+benchEvaluator(const char* name, const evaluator_t& eval, const vector<Board>& boards,
+               unsigned depth, unsigned reps)
+{
+    vector<Moves> moves;
+    vector<vector<Board>> newBoards;
+    for (unsigned i = 0; i < boards.size(); ++i) {
+        moves.push_back(legalMoves(boards[i], i % 2));
+        newBoards.emplace_back();
+        computeScores(eval, moves[i], i % 2, boards[i], newBoards[i]);
+    }
+
+    score_t checksum = 0;
+    bench::Timer evalTimer;
+    for (unsigned r = 0; r < reps; ++r) {
+        for (unsigned i = 0; i < boards.size(); ++i) {
+            const auto scores = eval(moves[i], i % 2, boards[i], newBoards[i]);
+            checksum += scores.empty()? 0 : scores[r % scores.size()];
+        }
+    }
+    const auto evalSecs = evalTimer.seconds();
+
+    uint64_t nodes = 0;
+    double searchSecs = 0;
+    for (unsigned i = 0; i < boards.size(); ++i) {
+        const player_id_t pid = i % 2;
+        if (moves[i].empty()) {
+            continue;
+        }
+        GameContext context(i);
+        const AlphaBetaPlayer player(depth, eval, pid, 0.01);
+        bench::Timer timer;
+        player.getMove(boards[i], moves[i], context);
+        searchSecs += timer.seconds();
+        nodes += player.nodesVisited();
+    }
+
+    cout << setw(10) << name << setw(12) << fixed << setprecision(1)
+         << 1e9 * evalSecs / (reps * boards.size())
+         << setw(14) << nodes << setw(9) << setprecision(2) << searchSecs
+         << setw(13) << setprecision(0) << nodes / searchSecs
+         << setw(14) << setprecision(3) << checksum / reps << endl;
+}
+
+
+int main(int argc, char** argv)
+{
+    const unsigned depth = (argc > 1)? atoi(argv[1]) : 8;
+    const unsigned reps = (argc > 2)? atoi(argv[2]) : 20000;
+    tbb::task_scheduler_init init(1);
+
+    const auto boards = bench::randomBoards(2, 3, 10);
+    cout << "Scoring and searching (alphabeta-" << depth << ") " << boards.size()
+         << " boards (one thread)\n";
+    cout << " evaluator  ns/board         nodes     secs    nodes/sec      checksum\n";
+    benchEvaluator("separate", separateEval, boards, depth, reps);
+    benchEvaluator("batched", batchedEval, boards, depth, reps);
+    benchEvaluator("fused", fusedEval, boards, depth, reps);
+
+    return 0;
+}
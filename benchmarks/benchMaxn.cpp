@@ -0,0 +1,110 @@
+// Benchmark: the max^n and paranoid players in 3- and 4-player games. First, the
+// nodes they search per second on a corpus of boards, and then how often they win
+// against greedy players, from every seat in turn (a greedy player would win
+// about 1/n of the games).
+// Usage: benchMaxn [depth] [games per no. of players]
+//
+
+#include "positions.h"
+
+#include "eval.h"
+#include "game_context.h"
+#include "maxn_player.h"
+#include "move_notifier.h"
+
+#include <tbb/task_scheduler_init.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+using namespace grandeur;
+using namespace std;
+
+static const auto positionEval =
+        combinePositions({ positionWin, positionPoints, positionPrestige, positionGems, positionNobleProgress },
+                         { 100, 2, 1, 1, 2 });
+
+static const char* modeName(MaxnPlayer::mode_t mode)
+{
+    return (mode == MaxnPlayer::MAXN)? "max^n" : "paranoid";
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Play one game, with a search player in the given seat and greedy players in the others.
+// Returns the winner (or a larger number if tied):
+static player_id_t
+playGame(MaxnPlayer::mode_t mode, unsigned depth, unsigned nplayer, player_id_t seat, uint64_t seed)
+{
+    vector<unique_ptr<const Player>> owned;
+    Players players;
+    for (player_id_t pid = 0; pid < nplayer; ++pid) {
+        owned.emplace_back((pid == seat)? new MaxnPlayer(mode, depth, positionEval, pid)
+                                        : PlayerFactory::instance().create("greedy", pid));
+        players.push_back(owned.back().get());
+    }
+
+    GameContext context(seed);
+    Deck deck(context.prng_);
+    auto board = bench::dealBoard(nplayer, deck, context.prng_);
+    const MoveNotifier notifier;
+    return mainGameLoop(board, deck, players, notifier, context);
+}
+
+
+int main(int argc, char** argv)
+{
+    const unsigned depth = (argc > 1)? atoi(argv[1]) : 3;
+    const unsigned games = (argc > 2)? atoi(argv[2]) : 24;
+    tbb::task_scheduler_init init;
+
+    cout << "Searching to depth " << depth << "\n";
+    cout << "players      search   boards         nodes     secs    nodes/sec\n";
+    for (unsigned nplayer = 3; nplayer <= MAX_NPLAYER; ++nplayer) {
+        const auto boards = bench::randomBoards(nplayer, 2, 8);
+        for (const auto mode : { MaxnPlayer::MAXN, MaxnPlayer::PARANOID }) {
+            uint64_t nodes = 0;
+            double secs = 0;
+            unsigned searched = 0;
+            for (unsigned i = 0; i < boards.size(); ++i) {
+                const player_id_t pid = i % nplayer;
+                const auto legal = legalMoves(boards[i], pid);
+                if (legal.empty()) {
+                    continue;
+                }
+                GameContext context(i);
+                const MaxnPlayer player(mode, depth, positionEval, pid);
+                bench::Timer timer;
+                player.getMove(boards[i], legal, context);
+                secs += timer.seconds();
+                nodes += player.nodesVisited();
+                ++searched;
+            }
+            cout << setw(7) << nplayer << setw(12) << modeName(mode) << setw(9) << searched
+                 << setw(14) << nodes << setw(9) << fixed << setprecision(2) << secs
+                 << setw(13) << setprecision(0) << nodes / secs << endl;
+        }
+    }
+
+    cout << "\nPlaying against greedy players, " << games << " games each\n";
+    cout << "players      search   wins   ties   win rate   ms/game\n";
+    for (unsigned nplayer = 3; nplayer <= MAX_NPLAYER; ++nplayer) {
+        for (const auto mode : { MaxnPlayer::MAXN, MaxnPlayer::PARANOID }) {
+            unsigned wins = 0, ties = 0;
+            bench::Timer timer;
+            for (unsigned game = 0; game < games; ++game) {
+                const player_id_t seat = game % nplayer;
+                const auto winner = playGame(mode, depth, nplayer, seat, game + 1);
+                wins += (winner == seat);
+                ties += (winner >= nplayer);
+            }
+            cout << setw(7) << nplayer << setw(12) << modeName(mode) << setw(7) << wins << setw(7) << ties
+                 << setw(11) << setprecision(2) << double(wins) / games
+                 << setw(10) << setprecision(1) << 1000 * timer.seconds() / games << endl;
+        }
+    }
+
+    return 0;
+}
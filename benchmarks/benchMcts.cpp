@@ -0,0 +1,67 @@
+// Benchmark: how many MCTS iterations per second each rollout policy achieves,
+// for 2--4 players, with one tree per thread for 1, 2, 4... threads (up to the
+// machine's hardware threads). Use it to size the hardware for a time budget.
+// Usage: benchMcts [milliseconds per move]
+//
+
+#include "positions.h"
+
+#include "eval.h"
+#include "game_context.h"
+#include "mcts_player.h"
+
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_init.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace grandeur;
+using namespace std;
+
+static const auto greedyEval =
+        combine({ winCondition, countPoints, countPrestige },
+                { 100,          2,           1 } );
+
+
+int main(int argc, char** argv)
+{
+    const unsigned millis = (argc > 1)? atoi(argv[1]) : 100;
+    const unsigned maxThreads = tbb::task_scheduler_init::default_num_threads();
+
+    cout << "Searching each board for " << millis << "ms\n";
+    cout << "rollout  players  threads  moves   iterations    iters/sec\n";
+    for (const auto rollout : { MctsPlayer::RANDOM_ROLLOUT, MctsPlayer::GREEDY_ROLLOUT }) {
+        for (unsigned nplayer = 2; nplayer <= MAX_NPLAYER; ++nplayer) {
+            const auto boards = bench::randomBoards(nplayer, 2, 12);
+            for (unsigned nthread = 1; nthread <= maxThreads; nthread *= 2) {
+                tbb::task_arena arena(nthread);
+                unsigned moves = 0;
+                uint64_t iterations = 0;
+                double secs = 0;
+
+                for (unsigned i = 0; i < boards.size(); ++i) {
+                    const player_id_t pid = i % nplayer;
+                    const auto legal = legalMoves(boards[i], pid);
+                    if (legal.size() < 2) {
+                        continue;
+                    }
+                    GameContext context(i);
+                    const MctsPlayer player(0, millis, rollout, greedyEval, pid, nthread);
+                    arena.execute([&]() { player.getMove(boards[i], legal, context); });
+                    ++moves;
+                    iterations += player.iterations();
+                    secs += player.seconds();
+                }
+
+                cout << setw(7) << (rollout == MctsPlayer::RANDOM_ROLLOUT? "random" : "greedy")
+                     << setw(9) << nplayer << setw(9) << nthread << setw(7) << moves
+                     << setw(13) << iterations
+                     << setw(13) << fixed << setprecision(0) << iterations / secs << endl;
+            }
+        }
+    }
+
+    return 0;
+}
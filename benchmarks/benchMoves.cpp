@@ -0,0 +1,87 @@
+// Benchmark: the memory footprint of moves and move lists, and the speed of move
+// generation and of deep searches, which keep a move list (and its scores) on
+// the stack at every level.
+// Usage: benchMoves [minimax depth] [alphabeta depth]
+//
+
+#include "positions.h"
+
+#include "eval.h"
+#include "game_context.h"
+#include "minimax_player.h"
+
+#include <tbb/task_scheduler_init.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace grandeur;
+using namespace std;
+
+static const auto allEval =
+        combine({ winCondition, countPoints, countPrestige, countGems, countMoves,
+                  monopolizeGems, preferWildcards, countReturns, preferShortGame, preferBuyTowardNoble },
+                { 100, 2, 1, 1, 0, 0, 0, -1, 1, 2 });
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Search every board with a player, and report its node rate:
+template <typename SearchPlayer>
+static void
+benchSearch(const char* name, unsigned depth, const vector<Board>& boards)
+{
+    uint64_t nodes = 0;
+    double secs = 0;
+    for (unsigned i = 0; i < boards.size(); ++i) {
+        const player_id_t pid = i % 2;
+        const auto legal = legalMoves(boards[i], pid);
+        if (legal.empty()) {
+            continue;
+        }
+        GameContext context(i);
+        const SearchPlayer player(depth, allEval, pid, 0.01);
+        bench::Timer timer;
+        player.getMove(boards[i], legal, context);
+        secs += timer.seconds();
+        nodes += player.nodesVisited();
+    }
+
+    cout << setw(10) << name << setw(7) << depth << setw(14) << nodes
+         << setw(9) << fixed << setprecision(2) << secs
+         << setw(13) << setprecision(0) << nodes / secs << endl;
+}
+
+
+int main(int argc, char** argv)
+{
+    const unsigned minimaxDepth = (argc > 1)? atoi(argv[1]) : 5;
+    const unsigned alphabetaDepth = (argc > 2)? atoi(argv[2]) : 8;
+    tbb::task_scheduler_init init(1);
+
+    cout << "GameMove: " << sizeof(GameMove) << " bytes, move list: " << sizeof(Moves)
+         << " bytes, move list + scores: " << sizeof(Moves) + sizeof(Scores) << " bytes\n";
+
+    const auto boards = bench::randomBoards(2, 3, 10);
+    constexpr unsigned reps = 20000;
+    uint64_t nmoves = 0;
+    Moves moves;
+    bench::Timer timer;
+    for (unsigned r = 0; r < reps; ++r) {
+        for (unsigned i = 0; i < boards.size(); ++i) {
+            legalMoves(boards[i], i % 2, moves);
+            nmoves += moves.size();
+        }
+    }
+    const auto secs = timer.seconds();
+    cout << "legalMoves: " << fixed << setprecision(1)
+         << secs * 1e9 / (reps * boards.size()) << " ns/call, "
+         << nmoves / secs / 1e6 << " M moves/sec\n\n";
+
+    cout << "Searching " << boards.size() << " boards (one thread)\n";
+    cout << "    player  depth         nodes     secs    nodes/sec\n";
+    benchSearch<MinimaxPlayer>("minimax", minimaxDepth, boards);
+    benchSearch<AlphaBetaPlayer>("alphabeta", alphabetaDepth, boards);
+
+    return 0;
+}
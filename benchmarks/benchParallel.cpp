@@ -0,0 +1,80 @@
+// Benchmark: how alpha-beta search scales with threads. Searches the same corpus
+// of two-player boards to a fixed depth with 1, 2, ... threads, and reports each
+// run's speedup and parallel efficiency over the one-thread run, its node count
+// (parallel search may prune less), and how many moves agree with one thread.
+// Usage: benchParallel [alphabeta depth] [max threads]
+//
+
+#include "positions.h"
+
+#include "eval.h"
+#include "game_context.h"
+#include "minimax_player.h"
+
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_init.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace grandeur;
+using namespace std;
+
+static const auto allEval =
+        combine({ winCondition, countPoints, countPrestige, countGems, countMoves,
+                  monopolizeGems, preferWildcards, countReturns, preferShortGame, preferBuyTowardNoble },
+                { 100, 2, 1, 1, 0, 0, 0, -1, 1, 2 });
+
+
+int main(int argc, char** argv)
+{
+    const unsigned depth = (argc > 1)? atoi(argv[1]) : 6;
+    const unsigned maxThreads = (argc > 2)? atoi(argv[2]) : tbb::task_scheduler_init::default_num_threads();
+
+    const auto boards = bench::randomBoards(2, 3, 10);
+    cout << "Searching " << boards.size() << " boards with alphabeta-" << depth << "\n";
+    cout << "threads     secs  speedup  efficiency           nodes    nodes/sec  same moves\n";
+
+    vector<GameMove> serialMoves;
+    double serialSecs = 0;
+    for (unsigned nthread = 1; nthread <= maxThreads; ++nthread) {
+        tbb::task_scheduler_init init(nthread);
+        tbb::task_arena arena(nthread);
+        uint64_t nodes = 0;
+        double secs = 0;
+        unsigned same = 0, total = 0;
+
+        for (unsigned i = 0; i < boards.size(); ++i) {
+            const player_id_t pid = i % 2;
+            const auto legal = legalMoves(boards[i], pid);
+            if (legal.empty()) {
+                continue;
+            }
+            GameContext context(i);
+
+            const AlphaBetaPlayer player(depth, allEval, pid, 0.01);
+            GameMove move;
+            bench::Timer timer;
+            arena.execute([&] { move = player.getMove(boards[i], legal, context); });
+            secs += timer.seconds();
+            nodes += player.nodesVisited();
+
+            if (nthread == 1) {
+                serialMoves.push_back(move);
+            }
+            same += (move == serialMoves[total++]);
+        }
+
+        if (nthread == 1) {
+            serialSecs = secs;
+        }
+        const auto speedup = serialSecs / secs;
+        cout << setw(7) << nthread << setw(9) << fixed << setprecision(2) << secs
+             << setw(9) << speedup << setw(12) << speedup / nthread
+             << setw(16) << nodes << setw(13) << setprecision(0) << nodes / secs
+             << setw(8) << same << "/" << total << endl;
+    }
+
+    return 0;
+}
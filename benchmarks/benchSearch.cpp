@@ -0,0 +1,81 @@
+// Benchmark: compare the no. of nodes and time that plain minimax and alpha-beta
+// search need to pick the (same) move, over a corpus of two-player boards.
+// Usage: benchSearch [max alphabeta depth] [max minimax depth]
+//
+
+#include "positions.h"
+
+#include "eval.h"
+#include "game_context.h"
+#include "minimax_player.h"
+
+#include <tbb/task_scheduler_init.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace grandeur;
+using namespace std;
+
+static const auto allEval =
+        combine({ winCondition, countPoints, countPrestige, countGems, countMoves,
+                  monopolizeGems, preferWildcards, countReturns, preferShortGame, preferBuyTowardNoble },
+                { 100, 2, 1, 1, 0, 0, 0, -1, 1, 2 });
+
+
+int main(int argc, char** argv)
+{
+    const unsigned maxDepth = (argc > 1)? atoi(argv[1]) : 5;
+    const unsigned maxMinimaxDepth = (argc > 2)? atoi(argv[2]) : 4;
+    tbb::task_scheduler_init init;
+
+    const auto boards = bench::randomBoards(2, 3, 10);
+    cout << "Searching " << boards.size() << " boards\n";
+    cout << "depth   minimax nodes     secs   alphabeta nodes     secs   node ratio  same moves\n";
+
+    for (unsigned depth = 1; depth <= maxDepth; ++depth) {
+        uint64_t mmNodes = 0, abNodes = 0;
+        double mmSecs = 0, abSecs = 0;
+        unsigned same = 0, total = 0;
+
+        for (unsigned i = 0; i < boards.size(); ++i) {
+            const player_id_t pid = i % 2;
+            const auto legal = legalMoves(boards[i], pid);
+            if (legal.empty()) {
+                continue;
+            }
+            GameContext context(i);
+            ++total;
+
+            const AlphaBetaPlayer alphabeta(depth, allEval, pid, 0.01);
+            bench::Timer abTimer;
+            const auto abMove = alphabeta.getMove(boards[i], legal, context);
+            abSecs += abTimer.seconds();
+            abNodes += alphabeta.nodesVisited();
+
+            if (depth <= maxMinimaxDepth) {
+                const MinimaxPlayer minimax(depth, allEval, pid, 0.01);
+                bench::Timer mmTimer;
+                same += (minimax.getMove(boards[i], legal, context) == abMove);
+                mmSecs += mmTimer.seconds();
+                mmNodes += minimax.nodesVisited();
+            }
+        }
+
+        cout << setw(5) << depth;
+        if (depth <= maxMinimaxDepth) {
+            cout << setw(16) << mmNodes << setw(9) << fixed << setprecision(2) << mmSecs;
+        } else {
+            cout << setw(16) << "-" << setw(9) << "-";
+        }
+        cout << setw(18) << abNodes << setw(9) << fixed << setprecision(2) << abSecs;
+        if (depth <= maxMinimaxDepth) {
+            cout << setw(12) << setprecision(1) << double(mmNodes) / abNodes
+                 << setw(8) << same << "/" << total;
+        }
+        cout << endl;
+    }
+
+    return 0;
+}
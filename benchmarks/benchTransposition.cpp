@@ -0,0 +1,82 @@
+// Benchmark: how much the transposition table saves minimax and alpha-beta
+// search, and how often it finds a board it has seen before.
+// Usage: benchTransposition [max alphabeta depth] [max minimax depth]
+//
+
+#include "positions.h"
+
+#include "eval.h"
+#include "game_context.h"
+#include "minimax_player.h"
+
+#include <tbb/task_scheduler_init.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace grandeur;
+using namespace std;
+
+static const auto allEval =
+        combine({ winCondition, countPoints, countPrestige, countGems, countMoves,
+                  monopolizeGems, preferWildcards, countReturns, preferShortGame, preferBuyTowardNoble },
+                { 100, 2, 1, 1, 0, 0, 0, -1, 1, 2 });
+
+
+// Search all boards with a fresh player per board, and print the totals:
+template <class SearchPlayer>
+void
+searchAll(const char* name, unsigned depth, const vector<Board>& boards)
+{
+    uint64_t nodes[2] = { 0, 0 }, probes = 0, hits = 0;
+    double secs[2] = { 0, 0 };
+
+    for (unsigned i = 0; i < boards.size(); ++i) {
+        const player_id_t pid = i % 2;
+        const auto legal = legalMoves(boards[i], pid);
+        if (legal.empty()) {
+            continue;
+        }
+        GameContext context(i);
+
+        for (unsigned withTT = 0; withTT < 2; ++withTT) {
+            const SearchPlayer player(depth, allEval, pid, 0.01, withTT? DEFAULT_TT_SIZE_LOG2 : 0);
+            bench::Timer timer;
+            player.getMove(boards[i], legal, context);
+            secs[withTT] += timer.seconds();
+            nodes[withTT] += player.nodesVisited();
+            if (withTT) {
+                probes += player.transpositions().probes();
+                hits += player.transpositions().hits();
+            }
+        }
+    }
+
+    cout << setw(10) << name << setw(6) << depth
+         << setw(14) << nodes[0] << setw(9) << fixed << setprecision(2) << secs[0]
+         << setw(14) << nodes[1] << setw(9) << secs[1]
+         << setw(12) << setprecision(1) << 100. * (1. - double(nodes[1]) / nodes[0]) << "%"
+         << setw(11) << 100. * hits / max<uint64_t>(probes, 1) << "%" << endl;
+}
+
+
+int main(int argc, char** argv)
+{
+    const unsigned maxDepth = (argc > 1)? atoi(argv[1]) : 6;
+    const unsigned maxMinimaxDepth = (argc > 2)? atoi(argv[2]) : 4;
+    tbb::task_scheduler_init init;
+
+    const auto boards = bench::randomBoards(2, 3, 10);
+    cout << "Searching " << boards.size() << " boards\n";
+    cout << "    player depth  nodes w/o TT     secs  nodes w/ TT     secs   node saving   hit rate\n";
+
+    for (unsigned depth = 3; depth <= maxMinimaxDepth; ++depth) {
+        searchAll<MinimaxPlayer>("minimax", depth, boards);
+    }
+    for (unsigned depth = 3; depth <= maxDepth; ++depth) {
+        searchAll<AlphaBetaPlayer>("alphabeta", depth, boards);
+    }
+
+    return 0;
+}
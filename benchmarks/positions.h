@@ -0,0 +1,93 @@
+// Utilities shared by the benchmarks: a reproducible corpus of realistic boards,
+// and a simple wall-clock timer.
+//
+
+#pragma once
+
+#include "board.h"
+#include "card.h"
+#include "move.h"
+#include "noble.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace grandeur {
+namespace bench {
+
+// Deal the initial table cards from a shuffled deck, and nobles at random, like
+// the game does:
+inline Board
+dealBoard(unsigned nplayer, Deck& deck, std::mt19937_64& prng)
+{
+    Cards initial;
+    for (int dt = LOW; dt <= HIGH; ++dt) {
+        for (unsigned i = 0; i < INITIAL_DECK_NCARD; ++i) {
+            initial.push_back(deck.draw(deck_t(dt)));
+        }
+    }
+    std::vector<Noble> nobles(std::begin(g_nobles), std::end(g_nobles));
+    std::shuffle(std::begin(nobles), std::end(nobles), prng);
+    nobles.erase(nobles.begin() + g_noble_allocation[nplayer], nobles.end());
+
+    return Board(nplayer, initial, Board::Nobles(nobles.cbegin(), nobles.cend()));
+}
+
+
+// Play random legal moves from a few seeded games, and collect a board every
+// `stride` moves. Cards are replaced from a shuffled deck, just like in a real game.
+inline std::vector<Board>
+randomBoards(unsigned nplayer, unsigned ngames, unsigned stride = 6, unsigned maxMoves = 60)
+{
+    std::vector<Board> ret;
+    for (unsigned seed = 1; seed <= ngames; ++seed) {
+        std::mt19937_64 prng(seed);
+        Deck deck(prng);
+
+        auto board = dealBoard(nplayer, deck, prng);
+        for (unsigned mv = 0; mv < maxMoves && !board.gameOver(); ++mv) {
+            const player_id_t pid = mv % nplayer;
+            if (pid == 0) {
+                board.newRound();
+            }
+            const auto legal = legalMoves(board, pid);
+            if (legal.empty()) {
+                continue;
+            }
+            std::uniform_int_distribution<> dist(0, legal.size() - 1);
+            auto move = legal[dist(prng)];
+            Card replacement = NULL_CARD;
+            if (move.type() == RESERVE_CARD && move.card().isWild()) {
+                move = GameMove(deck.draw(move.card().id_.type_), RESERVE_CARD);
+            } else if (move.type() != TAKE_GEMS
+                    && cardIn(move.card().id_, board.tableCards())) {
+                replacement = deck.draw(move.card().id_.type_);
+            }
+            makeMove(board, pid, move, replacement);
+            if (mv % stride == stride - 1) {
+                ret.push_back(board);
+            }
+        }
+    }
+    return ret;
+}
+
+
+// Measure elapsed wall-clock time in seconds since construction:
+class Timer {
+  public:
+    Timer() : start_(std::chrono::steady_clock::now()) {}
+
+    double seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+  private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace bench
+}  // namespace grandeur
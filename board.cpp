@@ -4,6 +4,7 @@
 
 #include "board.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -13,14 +14,29 @@ namespace grandeur {
 
 //////////////////////////////////////////////////////////////////////////////////////
 Board::Board(unsigned nplayer, const Cards& initialCards, const Nobles& initialNobles)
-  : nplayer_(nplayer), cards_(initialCards), purchased_(), nobles_(initialNobles),
-    tableGems_(g_gem_allocation[nplayer]), playerGems_(nplayer),
-    playerPrestige_(nplayer), playerPoints_(nplayer), playerReserves_(nplayer),
+  : nplayer_(nplayer), cards_(initialCards.cbegin(), initialCards.cend()), onTable_(),
+    reserved_(), purchased_(), nobles_(initialNobles), tableGems_(g_gem_allocation[nplayer]), playerGems_(),
+    playerPrestige_(), playerPoints_(), playerReserves_(),
     remainingCards_(), round_(0)
 {
+    assert(nplayer <= MAX_NPLAYER);
     remainingCards_[LOW] = deckCount(LOW, g_deck) - deckCount(LOW, cards_);
     remainingCards_[MEDIUM] = deckCount(MEDIUM, g_deck) - deckCount(MEDIUM, cards_);
     remainingCards_[HIGH] = deckCount(HIGH, g_deck) - deckCount(HIGH, cards_);
+    for (const auto idx : cards_.indices()) {
+        onTable_.set(idx);
+    }
+    hash_ = fullHash();
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+void
+Board::newRound()
+{
+    hash_ ^= g_zobrist.round_[min(round_, ZobristKeys::MAX_ROUND - 1)];
+    ++round_;
+    hash_ ^= g_zobrist.round_[min(round_, ZobristKeys::MAX_ROUND - 1)];
 }
 
 
@@ -32,6 +48,7 @@ Board::takeGems(player_id_t pid, const Gems& gems)
     assert(pid < player_id_t(nplayer_));
     assert(totalGameGems() == g_gem_allocation[nplayer_]);
     assert(playerGems_[pid].totalGems() <= MAX_PLAYER_GEMS);
+    assert(hash_ == fullHash());
 
     // Can't take yellows:
     if (gems.getCount(YELLOW) > 0) {
@@ -83,8 +100,10 @@ Board::takeGems(player_id_t pid, const Gems& gems)
     }
 
     // Phew, everything seems in order. Let's take those gems!
+    hash_ ^= playerKey(pid) ^ gemsKey(g_zobrist.tableGems_, tableGems_);
     playerGems_[pid] += gems;
     tableGems_ -= gems;
+    hash_ ^= playerKey(pid) ^ gemsKey(g_zobrist.tableGems_, tableGems_);
 
     return LEGAL_MOVE;
 }
@@ -99,6 +118,7 @@ Board::buyCard(player_id_t pid, CardID cid, const Card& replacement)
     ///// First, check for bad programmatic inputs (bugs):
     assert(pid < player_id_t(nplayer_));
     assert(totalGameGems() == g_gem_allocation[nplayer_]);
+    assert(hash_ == fullHash());
 
     // Ensure that any replacement card comes from non-empty deck:
     assert(replacement.isNull() || remainingCards_[replacement.id_.type_] > 0);
@@ -111,32 +131,32 @@ Board::buyCard(player_id_t pid, CardID cid, const Card& replacement)
 
     // Ensure replacement is legitimate (not previously seen):
     assert(!replacement.isWild());
-    assert(!cardIn(replacement.id_, cards_));
-    assert(!cardIn(replacement.id_, purchased_));
-    for (auto i = 0; i < nplayer_; ++i) {
-        assert(!cardIn(replacement.id_, playerReserves_[i]));
-    }
+    assert(replacement.isNull() || !onTable_[replacement.id_.seq_]);
+    assert(replacement.isNull() || !purchased_[replacement.id_.seq_]);
+    assert(replacement.isNull() || !reserved_[replacement.id_.seq_]);
+    assert(masksMatch());
 
     ///// Next, check for bad user inputs:
     if (cid.seq_ == WILDCARD) {
         return BUY_WILDCARD;
     }
 
-    // Ensure card hasn't been purchased before:
-    if(cardIn(cid, purchased_)) {
+    // Ensure card exists and hasn't been purchased before:
+    if (cid.seq_ < 0 || unsigned(cid.seq_) >= NCARDS || purchased_[cid.seq_]) {
         return UNAVAILABLE_CARD;
     }
 
     //// Proceed to find the card to buy, check it's good, and if so, buy it:
     // Start with table cards:
-    auto where = cardLocation(cid, cards_);
-    if (where != end(cards_)) {
-        return (buyCardFromPile(pid, where, cards_, replacement));
+    if (onTable_[cid.seq_]) {
+        return (buyCardFromPile(pid, cards_.find(cid.seq_), cards_, replacement));
     }
 
-    where = cardLocation(cid, playerReserves_[pid]);
-    if (where != end(playerReserves_[pid])) {
-        return (buyCardFromPile(pid, where, playerReserves_[pid], replacement));
+    if (reserved_[cid.seq_]) {
+        const auto pos = playerReserves_[pid].find(cid.seq_);
+        if (pos >= 0) {
+            return (buyCardFromPile(pid, pos, playerReserves_[pid], replacement));
+        }
     }
 
     // Couldn't find cid in any eligible pile, so it's a bad input.
@@ -154,6 +174,7 @@ Board::reserveCard(player_id_t pid, const Card& card, const Card& replacement)
     ///// First, check for bad programmatic inputs (bugs):
     assert(pid < player_id_t(nplayer_));
     assert(totalGameGems() == g_gem_allocation[nplayer_]);
+    assert(hash_ == fullHash());
     assert(!card.isNull());
 
     // Ensure that any replacement card comes from non-empty deck
@@ -161,11 +182,10 @@ Board::reserveCard(player_id_t pid, const Card& card, const Card& replacement)
 
     // Ensure replacment is legitimate (not previously seen):
     assert(!replacement.isWild());
-    assert(!cardIn(replacement.id_, cards_));
-    assert(!cardIn(replacement.id_, purchased_));
-    for (auto i = 0; i < nplayer_; ++i) {
-        assert(!cardIn(replacement.id_, playerReserves_[i]));
-    }
+    assert(replacement.isNull() || !onTable_[replacement.id_.seq_]);
+    assert(replacement.isNull() || !purchased_[replacement.id_.seq_]);
+    assert(replacement.isNull() || !reserved_[replacement.id_.seq_]);
+    assert(masksMatch());
 
     ///// Next, check for bad user inputs:
     // Can't reserve too many cards:
@@ -187,41 +207,145 @@ Board::reserveCard(player_id_t pid, const Card& card, const Card& replacement)
 
     // Ensure card hasn't been purchased or reserved before:
     if (!card.isWild()) {
-        if (cardIn(card.id_, purchased_)) {
+        if (card.id_.seq_ < 0 || unsigned(card.id_.seq_) >= NCARDS
+         || purchased_[card.id_.seq_] || reserved_[card.id_.seq_]) {
             return UNAVAILABLE_CARD;
         }
-        for (auto i = 0; i < nplayer_; ++i) {
-            if (cardIn(card.id_, playerReserves_[i])) {
-                return UNAVAILABLE_CARD;
-            }
-        }
         // If card has a replacement, it must be found in table cards:
-        if (!replacement.isNull() && !cardIn(card.id_, cards_)) {
+        if (!replacement.isNull() && !onTable_[card.id_.seq_]) {
             return UNAVAILABLE_CARD;
         }
     }
 
-    auto where = cardLocation(card.id_, cards_);
-    if (where == cards_.cend()) {   // Undealt card:
+    const auto idx = cardIndex(card);
+    if (card.isWild() || !onTable_[idx]) {   // Undealt card:
         assert(remainingCards_[card.id_.type_] > 0);
+        hash_ ^= g_zobrist.remaining_[card.id_.type_][remainingCards_[card.id_.type_]];
         --remainingCards_[card.id_.type_];
+        hash_ ^= g_zobrist.remaining_[card.id_.type_][remainingCards_[card.id_.type_]];
     } else {  // Table card
-        removeCard(cards_, where, replacement);
+        removeCard(cards_, cards_.find(idx), replacement);
     }
 
-    playerReserves_[pid].push_back(card);
+    hash_ ^= reserveKey(pid, idx);
+    hash_ ^= playerKey(pid) ^ gemsKey(g_zobrist.tableGems_, tableGems_);
+    playerReserves_[pid].push_back(idx);
+    if (!card.isWild()) {
+        reserved_.set(idx);
+    }
     playerGems_[pid].inc(YELLOW);
     tableGems_.dec(YELLOW);
+    hash_ ^= playerKey(pid) ^ gemsKey(g_zobrist.tableGems_, tableGems_);
     return LEGAL_MOVE;
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////
+// Only a handful of board elements change in any move. Scalars are simply saved, but
+// for piles of cards we only note where a card was removed from (or added to).
+Board::UndoRecord
+Board::apply(player_id_t pid, const GameMove& move, const Card& replacement)
+{
+    assert(pid < player_id_t(nplayer_));
+
+    UndoRecord record;
+    record.pid_ = pid;
+    record.type_ = move.type();
+    record.playerGems_ = playerGems_[pid];
+    record.playerPrestige_ = playerPrestige_[pid];
+    record.tableGems_ = tableGems_;
+    record.playerPoints_ = playerPoints_[pid];
+    copy(begin(remainingCards_), end(remainingCards_), begin(record.remainingCards_));
+    record.round_ = round_;
+    record.hash_ = hash_;
+    record.replaced_ = !replacement.isNull();
+
+    if (move.type() != TAKE_GEMS) {
+        const auto idx = move.index();
+        if (idx < NCARDS && onTable_[idx]) {
+            record.card_ = idx;
+            record.tablePos_ = cards_.find(idx);
+        }
+    }
+
+    if (move.type() == BUY_CARD) {
+        if (record.tablePos_ < 0) {
+            record.card_ = move.index();
+            record.reservePos_ = playerReserves_[pid].find(record.card_);
+            assert(record.reservePos_ >= 0);
+        }
+
+        record.nobles_ = nobles_;
+    }
+
+    const auto status = makeMove(*this, pid, move, replacement);
+    assert(LEGAL_MOVE == status);
+    (void)status;
+    return record;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+void
+Board::undo(const UndoRecord& record)
+{
+    const auto pid = record.pid_;
+    assert(pid < player_id_t(nplayer_));
+
+    playerGems_[pid] = record.playerGems_;
+    playerPrestige_[pid] = record.playerPrestige_;
+    tableGems_ = record.tableGems_;
+    playerPoints_[pid] = record.playerPoints_;
+    copy(begin(record.remainingCards_), end(record.remainingCards_), begin(remainingCards_));
+    round_ = record.round_;
+    hash_ = record.hash_;
+
+    switch (record.type_) {
+    case TAKE_GEMS:
+        break;
+
+    case BUY_CARD:
+        purchased_.reset(record.card_);
+        if (record.reservePos_ >= 0) {
+            playerReserves_[pid].insert(record.reservePos_, record.card_);
+            reserved_.set(record.card_);
+        }
+        nobles_ = record.nobles_;
+        break;
+
+    case RESERVE_CARD: {
+        const auto idx = playerReserves_[pid].index(playerReserves_[pid].size() - 1);
+        if (idx < NCARDS) {
+            reserved_.reset(idx);
+        }
+        playerReserves_[pid].pop_back();
+        break;
+      }
+    }
+
+    if (record.tablePos_ >= 0) {
+        if (record.replaced_) {
+            onTable_.reset(cards_.index(record.tablePos_));
+            cards_.replace(record.tablePos_, record.card_);
+        } else {
+            cards_.insert(record.tablePos_, record.card_);
+        }
+        onTable_.set(record.card_);
+    }
+
+    assert(hash_ == fullHash());
+    assert(masksMatch());
+}
+
+
 //////////////////////////////////////////////////////////////////////////////////////
 // A game is over when a player reached MIN_WIN_POINTS or when all table cards
-// have been exhausted
+// have been exhausted. Seats past nplayer_ never score, so all MAX_NPLAYER of
+// them are checked, which the compiler unrolls.
 bool
 Board::gameOver() const
 {
+    assert(all_of(begin(playerPoints_) + nplayer_, end(playerPoints_), [](points_t p) { return p == 0; }));
     return (*max_element(begin(playerPoints_), end(playerPoints_)) >= MIN_WIN_POINTS
          || cards_.empty()
          || round_ > MAX_GAME_ROUNDS);
@@ -248,7 +372,7 @@ Board::leadingPlayer() const
 
 
 //////////////////////////////////////////////////////////////////////////////////////
-const Cards&
+const Board::TableCards&
 Board::tableCards() const
 {
     assert(cards_.size() <= INITIAL_DECK_NCARD * NDECKS);
@@ -257,11 +381,11 @@ Board::tableCards() const
 
 
 //////////////////////////////////////////////////////////////////////////////////////
-const Cards&
+const Board::Reserves&
 Board::playerReserves(player_id_t pid) const
 {
-    assert(playerReserves_.at(pid).size() <= MAX_PLAYER_RESERVES);
-    return playerReserves_.at(pid);
+    assert(pid < player_id_t(nplayer_));
+    return playerReserves_[pid];
 }
 
 
@@ -294,32 +418,96 @@ Board::remainingCards(unsigned deck) const
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////
+bool
+Board::isUndealt(const Card& card) const
+{
+    assert(!card.isNull() && !card.isWild());
+    const auto idx = card.id_.seq_;
+    return !purchased_[idx] && !onTable_[idx] && !reserved_[idx];
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+CardMask
+Board::undealtCards(deck_t dt) const
+{
+    static const auto deckMasks = [] {
+        array<CardMask, NDECKS> ret;
+        for (unsigned idx = 0; idx < NCARDS; ++idx) {
+            ret[g_card_table.deck_[idx]].set(idx);
+        }
+        return ret;
+    }();
+
+    assert(dt < NDECKS);
+    return deckMasks[dt] & ~(purchased_ | onTable_ | reserved_);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// Prestige discounts every card's cost, so a player can afford the cards that their
+// gems and prestige together can pay for in full.
+CardMask
+Board::affordableCards(player_id_t pid) const
+{
+    assert(pid < player_id_t(nplayer_));
+    CardMask candidates = onTable_;
+    for (const auto idx : playerReserves_[pid].indices()) {
+        if (idx < NCARDS) {
+            candidates[idx] = true;
+        }
+    }
+
+    const auto ret = candidates & ~g_cost_masks.beyondReach(playerGems_[pid] + playerPrestige_[pid]);
+
+#ifndef NDEBUG
+    // Check against paying for every card separately:
+    for (const auto idx : cards_.indices()) {
+        assert(ret[idx] == canAfford(pid, idx));
+    }
+    for (const auto idx : playerReserves_[pid].indices()) {
+        assert(idx >= NCARDS || ret[idx] == canAfford(pid, idx));
+    }
+#endif
+    return ret;
+}
+
+
 //////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////
 // buyCardsFromPile does the actual bookkeeping, once we've identified where we're buying
 // the card from (table cards, reserves, etc.). We still have to check for adequate gems.
+template <class Pile>
 MoveStatus
-Board::buyCardFromPile(player_id_t pid, typename Cards::iterator where,
-                       Cards& pile, const Card& replacement)
+Board::buyCardFromPile(player_id_t pid, unsigned pos, Pile& pile, const Card& replacement)
 {
-    assert(where->cost_.getCount(YELLOW) == 0);
+    const auto idx = pile.index(pos);
+    assert(g_card_table.cost_[idx].getCount(YELLOW) == 0);
     assert(pid < player_id_t(nplayer_));
 
     // Compute how many gems we'll have left after the purchase, complement from yellows
     // as necessary.
-    auto balance = playerGems_[pid].actualCost(where->cost_ - playerPrestige_[pid]);
+    auto balance = playerGems_[pid].actualCost(g_card_table.cost_[idx] - playerPrestige_[pid]);
+    assert(canAfford(pid, idx) == !(playerGems_[pid] - balance).hasNegatives());
     if ((playerGems_[pid] - balance).hasNegatives()) {
         return INSUFFICIENT_GEMS;
     }
 
     // OK, successful, update quantities:
-    purchased_.push_back(*where);
+    hash_ ^= playerKey(pid) ^ gemsKey(g_zobrist.tableGems_, tableGems_);
+    purchased_.set(idx);
     tableGems_ += balance;
     playerGems_[pid] -= balance;
-    playerPrestige_[pid].inc(where->color_);
-    playerPoints_[pid] += where->points_;
+    playerPrestige_[pid].inc(g_card_table.color_[idx]);
+    playerPoints_[pid] += g_card_table.points_[idx];
+    hash_ ^= playerKey(pid) ^ gemsKey(g_zobrist.tableGems_, tableGems_);
 
-    removeCard(pile, where, replacement);
+    if (!is_same<Pile, TableCards>::value) {
+        hash_ ^= reserveKey(pid, idx);
+        reserved_.reset(idx);
+    }
+    removeCard(pile, pos, replacement);
     checkNobles(pid);
 
     return LEGAL_MOVE;
@@ -327,15 +515,28 @@ Board::buyCardFromPile(player_id_t pid, typename Cards::iterator where,
 
 //////////////////////////////////////////////////////////////////////////////////////
 // Update pile and remainingCards_ after a table card has been purchased or reserved
+// (the caller is responsible for hashing the card out of a pile other than cards_).
+template <class Pile>
 void
-Board::removeCard(Cards& pile, typename Cards::iterator& where, const Card& replacement)
+Board::removeCard(Pile& pile, unsigned pos, const Card& replacement)
 {
+    if (is_same<Pile, TableCards>::value) {
+        hash_ ^= g_zobrist.tableCards_[pile.index(pos)];
+        onTable_.reset(pile.index(pos));
+    }
+
     if (replacement.isNull()) {
-        pile.erase(where);
+        pile.erase(pos);
     } else {
-        *where = replacement;
+        assert((is_same<Pile, TableCards>::value));
+        const auto idx = cardIndex(replacement);
+        pile.replace(pos, idx);
+        onTable_.set(idx);
         assert(remainingCards_[replacement.id_.type_] > 0);
+        hash_ ^= g_zobrist.tableCards_[idx];
+        hash_ ^= g_zobrist.remaining_[replacement.id_.type_][remainingCards_[replacement.id_.type_]];
         --remainingCards_[replacement.id_.type_];
+        hash_ ^= g_zobrist.remaining_[replacement.id_.type_][remainingCards_[replacement.id_.type_]];
     }
 }
 
@@ -346,7 +547,9 @@ Board::checkNobles(player_id_t pid)
 {
     for (auto iter = nobles_.begin(); iter != nobles_.end(); ) {
         if (!(playerPrestige_[pid] - iter->cost_).hasNegatives()) {
+            hash_ ^= playerKey(pid) ^ g_zobrist.nobles_[nobleIndex(*iter)];
             playerPoints_[pid] += iter->points_;
+            hash_ ^= playerKey(pid);
             iter = nobles_.erase(iter);
         } else {
             ++iter;
@@ -370,6 +573,96 @@ Board::totalGameGems() const
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////
+uint64_t
+Board::playerKey(player_id_t pid) const
+{
+    return gemsKey(g_zobrist.playerGems_[pid], playerGems_[pid])
+         ^ gemsKey(g_zobrist.prestige_[pid], playerPrestige_[pid])
+         ^ g_zobrist.points_[pid][min(playerPoints_[pid], ZobristKeys::MAX_POINTS - 1)];
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+uint64_t
+Board::reserveKey(player_id_t pid, card_index_t idx) const
+{
+    if (idx < NCARDS) {
+        return g_zobrist.reserves_[pid][idx];
+    }
+
+    const auto dt = g_card_table.deck_[idx];
+    const auto& reserves = playerReserves_[pid].indices();
+    const unsigned count = std::count(reserves.cbegin(), reserves.cend(), idx);
+    assert(count < MAX_PLAYER_RESERVES);
+    return g_zobrist.wildReserves_[pid][dt][count] ^ g_zobrist.wildReserves_[pid][dt][count + 1];
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+uint64_t
+Board::fullHash() const
+{
+    uint64_t ret = gemsKey(g_zobrist.tableGems_, tableGems_)
+                 ^ g_zobrist.round_[min(round_, ZobristKeys::MAX_ROUND - 1)];
+
+    for (player_id_t pid = 0; pid < player_id_t(nplayer_); ++pid) {
+        ret ^= playerKey(pid);
+        unsigned wild[NDECKS] = { 0, 0, 0 };
+        for (const auto idx : playerReserves_[pid].indices()) {
+            if (idx >= NCARDS) {
+                ++wild[g_card_table.deck_[idx]];
+            } else {
+                ret ^= g_zobrist.reserves_[pid][idx];
+            }
+        }
+        for (unsigned dt = 0; dt < NDECKS; ++dt) {
+            ret ^= g_zobrist.wildReserves_[pid][dt][wild[dt]];
+        }
+    }
+
+    for (const auto idx : cards_.indices()) {
+        ret ^= g_zobrist.tableCards_[idx];
+    }
+    for (const auto& noble : nobles_) {
+        ret ^= g_zobrist.nobles_[nobleIndex(noble)];
+    }
+    for (unsigned dt = 0; dt < NDECKS; ++dt) {
+        ret ^= g_zobrist.remaining_[dt][remainingCards_[dt]];
+    }
+
+    return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+bool
+Board::canAfford(player_id_t pid, card_index_t idx) const
+{
+    assert(idx < NCARDS);
+    return (playerGems_[pid] + playerPrestige_[pid]).canPay(g_card_table.cost_[idx]);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+bool
+Board::masksMatch() const
+{
+    CardMask table, reserved;
+    for (const auto idx : cards_.indices()) {
+        table.set(idx);
+    }
+    for (player_id_t pid = 0; pid < player_id_t(nplayer_); ++pid) {
+        for (const auto idx : playerReserves_[pid].indices()) {
+            if (idx < NCARDS) {
+                reserved.set(idx);
+            }
+        }
+    }
+    return table == onTable_ && reserved == reserved_;
+}
+
+
 //////////////////////////////////////////////////////////////////////////////////////
 std::ostream&
 operator<<(std::ostream& os, const Board& board)
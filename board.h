@@ -1,6 +1,11 @@
 // Board class holds all the visible elements of a game board: the cards that
 // have been dealt, the resources and stats of each player, table resources,
 // the nobles, and the reserved cards (that were visible when reserved).
+// All of these have small upper bounds, so the board is stored in fixed-size
+// containers, and can be copied without any memory allocation. Cards are stored
+// as one-byte card indices, and which cards are on the table or reserved is also
+// kept in bitmasks, so checking where a card is doesn't require a search, and
+// which of them a player can afford is a few mask operations (see CostMasks).
 //
 // Created by eitan on 11/19/15.
 //
@@ -12,16 +17,23 @@
 #include "gems.h"
 #include "move.h"
 #include "noble.h"
+#include "static_vector.h"
+#include "zobrist.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <iosfwd>
-#include <vector>
+#include <type_traits>
 
 namespace grandeur {
 
 class Board {
   public:
-    using Nobles = std::vector<Noble>;
+    using TableCards = CardPile<INITIAL_DECK_NCARD * NDECKS>;
+    using Reserves = CardPile<MAX_PLAYER_RESERVES>;
+    using Nobles = StaticVector<Noble, MAX_NPLAYER + 1>;
 
     // Construct Board with the available no. of cards from each deck.
     Board(unsigned nplayer, const Cards& initialCards, const Nobles& initialNobles);
@@ -41,24 +53,73 @@ class Board {
     // the table cards, it's assumed to be in the undealt deck
     MoveStatus reserveCard(player_id_t pid, const Card& card, const Card& replacement = NULL_CARD);
 
-    void newRound() { ++round_; }  // Signal a full  round completed.
+    void newRound();  // Signal a full  round completed.
+
+    // Everything a move may change on the board, as it was before the move:
+    struct UndoRecord {
+        player_id_t pid_ = 0;
+        MoveType type_ = TAKE_GEMS;
+        Gems playerGems_, playerPrestige_, tableGems_;
+        points_t playerPoints_ = 0;
+        unsigned remainingCards_[NDECKS] = {};
+        unsigned round_ = 0;
+        uint64_t hash_ = 0;
+        card_index_t card_ = NULL_INDEX;  // The card that left the table or reserves, if any
+        int tablePos_ = -1;      // Where card_ was in the table cards (or -1)
+        int reservePos_ = -1;    // Where card_ was in the player's reserves (or -1)
+        bool replaced_ = false;  // Was card_ replaced on the table, or just removed?
+        Nobles nobles_;          // Table nobles before a purchase
+    };
+
+    // Make a legal move on this board in place (see makeMove()), and return a
+    // record of the changed state, so that the move can be taken back with undo().
+    // This is much cheaper than making the move on a copy of the board.
+    UndoRecord apply(player_id_t pid, const GameMove& move, const Card& replacement = NULL_CARD);
+
+    // Take back an applied move, along with any newRound() since. Moves must be
+    // undone in the reverse order they were applied.
+    void undo(const UndoRecord& record);
 
          //////////// Accessor functions:
 
     const player_id_t playersNum() const { return nplayer_; }
 
-    const Cards& tableCards() const;
-    const Cards& playerReserves(player_id_t pid) const;
+    const TableCards& tableCards() const;
+    const Reserves& playerReserves(player_id_t pid) const;
 
     const Gems& tableGems() const;
     const Gems& playerGems(player_id_t pid) const;
 
-    const Gems& playerPrestige(player_id_t pid) const { return playerPrestige_.at(pid); }
+    const Gems& playerPrestige(player_id_t pid) const
+    {
+        assert(pid < player_id_t(nplayer_));
+        return playerPrestige_[pid];
+    }
 
-    points_t playerPoints(player_id_t pid) const { return playerPoints_.at(pid); }
+    points_t playerPoints(player_id_t pid) const
+    {
+        assert(pid < player_id_t(nplayer_));
+        return playerPoints_[pid];
+    }
 
     unsigned remainingCards(unsigned deck) const;
 
+    // Could a card still be in its undealt deck, as far as the players can tell?
+    // (It's not on the table, in anyone's reserves, or purchased.)
+    bool isUndealt(const Card& card) const;
+
+    // All the cards of a deck type that could still be undealt:
+    CardMask undealtCards(deck_t dt) const;
+
+    // Is a (non-wild) card one of the table cards?
+    bool isOnTable(const Card& card) const
+    {
+        return !card.isWild() && !card.isNull() && onTable_[card.id_.seq_];
+    }
+
+    // Which table cards and own reserves can a player afford to buy right now?
+    CardMask affordableCards(player_id_t pid) const;
+
     const Nobles& tableNobles() const { return nobles_; }
 
     // How many rounds has this game played for so far?
@@ -71,32 +132,103 @@ class Board {
     // Has the game been won or played to completion?
     bool gameOver() const;
 
+    // A Zobrist hash of the board state, with the player about to move. Boards
+    // that are equal (up to the order of cards and nobles) have equal hashes.
+    uint64_t hash(player_id_t toMove) const { return hash_ ^ g_zobrist.side_[toMove]; }
+
   private:
-    // Like buyCard, but for a card in a specific set of cards:
-    MoveStatus buyCardFromPile(player_id_t pid, typename Cards::iterator where, Cards& pile,
-                               const Card& replacement);
+    // Like buyCard, but for a card in a specific set of cards (table or reserves):
+    template <class Pile>
+    MoveStatus buyCardFromPile(player_id_t pid, unsigned pos, Pile& pile, const Card& replacement);
 
     // Remove a card from a pile of cards, possibly with replacement:
-    void removeCard(Cards& pile, typename Cards::iterator& where, const Card& replacement);
+    template <class Pile>
+    void removeCard(Pile& pile, unsigned pos, const Card& replacement);
 
     // For debugging purposes:
     const Gems totalGameGems() const;
 
+    // The combined Zobrist key of a player's gems, prestige, and points:
+    uint64_t playerKey(player_id_t pid) const;
+
+    // The Zobrist key of a card reserved by a player. Unknown (wild) cards are
+    // hashed by their count in each deck, so this must be called before a
+    // reserved wildcard is added or after it's removed.
+    uint64_t reserveKey(player_id_t pid, card_index_t idx) const;
+
+    // Can a player pay for a (non-wild) card with their current gems and prestige?
+    bool canAfford(player_id_t pid, card_index_t idx) const;
+
+    // Do the card bitmasks match the piles? (For debugging.)
+    bool masksMatch() const;
+
+    // Compute the hash of the whole board from scratch (hash_ is updated incrementally):
+    uint64_t fullHash() const;
+
     int nplayer_;  // Total no. of players
-    Cards cards_;  // Visible cards
-    Cards purchased_; // A record of past purchased card for sanity checking
+    TableCards cards_;  // Visible cards
+    CardMask onTable_;    // The table cards, as a bitmask
+    CardMask reserved_;   // The (non-wild) cards reserved by any player
+    CardMask purchased_;  // A record of past purchased card for sanity checking
     Nobles nobles_;    // A collection of available noble tiles
     Gems tableGems_;  // Community gems
-    std::vector<Gems> playerGems_;   // The current resource count of each player
-    std::vector<Gems> playerPrestige_;   // The permanent resource discount of each player
-    std::vector<points_t> playerPoints_;   // How many points each player has.
-    std::vector<Cards> playerReserves_;  // Which visible cards each players has reserved
+    std::array<Gems, MAX_NPLAYER> playerGems_;   // The current resource count of each player
+    std::array<Gems, MAX_NPLAYER> playerPrestige_;   // The permanent resource discount of each player
+    std::array<points_t, MAX_NPLAYER> playerPoints_;   // How many points each player has.
+    std::array<Reserves, MAX_NPLAYER> playerReserves_;  // Which visible cards each players has reserved
     unsigned remainingCards_[NDECKS];  // How many cards remain of each deck type.
     unsigned round_;  // No. of game rounds, starting from one.
+    uint64_t hash_;   // Zobrist hash of all of the above.
 
     void checkNobles(player_id_t pid);
 };
 
+static_assert(std::is_trivially_copyable<Board>::value, "Boards should be copied as plain memory");
+
+
+// A Board with its no. of players fixed at compile time, for the loops that run
+// a whole game (the game loop, and MCTS rollouts), where checking whether the
+// game is over after every round is a loop over the players. It's a Board with
+// the same data, so it can be passed to anything that takes a Board, but there
+// it's generic again: only calls through a FixedBoard get the fixed loops.
+// (Making a move only changes the moving player, and needs no such loop.)
+template <unsigned NPLAYER>
+class FixedBoard : public Board {
+    static_assert(NPLAYER >= 2 && NPLAYER <= MAX_NPLAYER, "Unsupported no. of players");
+
+  public:
+    explicit FixedBoard(const Board& board) : Board(board) { assert(board.playersNum() == NPLAYER); }
+
+    static constexpr player_id_t playersNum() { return NPLAYER; }
+
+    bool gameOver() const
+    {
+        points_t maxPoints = 0;
+        for (player_id_t pid = 0; pid < NPLAYER; ++pid) {
+            maxPoints = std::max(maxPoints, playerPoints(pid));
+        }
+        const bool ret = maxPoints >= MIN_WIN_POINTS || tableCards().empty() || roundNumber() > MAX_GAME_ROUNDS;
+        assert(ret == Board::gameOver());
+        return ret;
+    }
+};
+
+// Call f with a board's no. of players as a compile-time constant (of type
+// std::integral_constant<unsigned, N>), to pick the FixedBoard<N> to use:
+template <class F>
+auto
+withPlayers(unsigned nplayer, F f) -> decltype(f(std::integral_constant<unsigned, 2>()))
+{
+    static_assert(MAX_NPLAYER == 4, "Every no. of players needs a case");
+    switch (nplayer) {
+    case 2: return f(std::integral_constant<unsigned, 2>());
+    case 3: return f(std::integral_constant<unsigned, 3>());
+    default:
+        assert(nplayer == 4);
+        return f(std::integral_constant<unsigned, 4>());
+    }
+}
+
 std::ostream& operator<<(std::ostream& os, const Board& board);
 
 } // namespace
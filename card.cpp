@@ -9,16 +9,81 @@
 
 namespace grandeur {
 
-Card popFromDeck(deck_t dt, Cards& cards) {
-    const auto iter = std::find_if(cards.begin(), cards.end(),
-                                   [dt](const Card& card){ return card.id_.type_ == dt; });
-    if (cards.end() == iter) {
-        return NULL_CARD;
+constexpr CardTable g_card_table;
+const CostMasks g_cost_masks;
+
+
+//////////////////////////////////////////////////////////////////////////////
+CostMasks::CostMasks()
+{
+    for (unsigned idx = 0; idx < NCARDS; ++idx) {
+        for (unsigned color = 0; color < NCOLOR - 1; ++color) {
+            for (int count = 0; count < g_card_table.cost_[idx].getCount(gem_color_t(color)); ++count) {
+                above_[color][count].set(idx);
+            }
+        }
     }
-    else {
-        auto ret = *iter;
-        cards.erase(iter);
-        return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// A card's shortage is how many more gems it costs than we have, over all colors,
+// and we can afford it if that's no more than our yellows. The shortage of every
+// card is counted at once, in unary: atLeast[n] holds the cards that are short at
+// least n gems (counting no higher than one more than the yellows).
+CardMask
+CostMasks::beyondReach(const Gems& gems) const
+{
+    const int yellows = gems.getCount(YELLOW);
+    assert(yellows >= 0 && yellows <= YELLOW_COUNT);
+
+    CardMask atLeast[YELLOW_COUNT + 2];
+    atLeast[0].set();
+    for (unsigned color = 0; color < NCOLOR - 1; ++color) {
+        const int have = gems.getCount(gem_color_t(color));
+        assert(have >= 0);
+        const int last = std::min(have + yellows + 1, int(MAX_CARD_COST));
+        for (int count = have; count < last; ++count) {
+            const auto& shortOneMore = above_[color][count];
+            for (int n = yellows + 1; n > 0; --n) {
+                atLeast[n] |= atLeast[n - 1] & shortOneMore;
+            }
+        }
+    }
+    return atLeast[yellows + 1];
+}
+
+
+static Cards
+shuffledCards(std::mt19937_64& prng)
+{
+    Cards cards(std::begin(g_deck), std::end(g_deck));
+    std::shuffle(cards.begin(), cards.end(), prng);
+    return cards;
+}
+
+
+Deck::Deck(std::mt19937_64& prng)
+  : Deck(shuffledCards(prng))
+{
+}
+
+
+Deck::Deck(const Cards& shuffled)
+  : cards_(), bottom_(), top_()
+{
+    assert(shuffled.size() <= NCARDS);
+    unsigned pos = 0;
+    for (int dt = LOW; dt <= HIGH; ++dt) {
+        bottom_[dt] = pos;
+        pos += deckCount(deck_t(dt), shuffled);
+        top_[dt] = pos;
+        auto next = top_[dt];
+        for (const auto& card : shuffled) {
+            if (card.id_.type_ == dt) {
+                cards_[--next] = cardIndex(card);
+            }
+        }
     }
 }
 
@@ -7,9 +7,16 @@
 
 #include "gems.h"
 #include "constants.h"
+#include "static_vector.h"
 
 #include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
+#include <iterator>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -101,11 +108,6 @@ bool cardIn(CardID cid, const Container& cards) {
     return (std::end(cards) != cardLocation(cid, cards));
 }
 
-// Find the first card of a given deck type in a deck, erase it and return it
-// returns NULL_CARD if no more cards left of this deck type
-Card popFromDeck(deck_t dt, Cards& cards);
-
-
 // Global constant card list for the full set of game cards.
 static constexpr const Card g_deck[] = {
         { { LOW, 0 }, { 1, 1, 1, 1, 0 }, BLACK, 0 },
@@ -200,4 +202,208 @@ static constexpr const Card g_deck[] = {
         { { HIGH, 89 }, { 0, 0, 7, 3, 0 }, RED, 5 }
 };
 
+// Total no. of cards in the game. A card's seq_ is its index in g_deck.
+static constexpr unsigned NCARDS = sizeof(g_deck) / sizeof(g_deck[0]);
+
+
+//////////////////////////////////////////////////////////////////////////////
+///// Card indices:
+
+// Boards and moves refer to cards by their index in g_deck, which fits in a byte.
+// The indices after the real cards stand for the deck wildcards and NULL_CARD.
+using card_index_t = uint8_t;
+
+static constexpr card_index_t WILDCARD_INDEX = NCARDS;  // Plus the deck type
+static constexpr card_index_t NULL_INDEX = NCARDS + NDECKS;
+static constexpr unsigned NCARD_INDICES = NULL_INDEX + 1;
+
+constexpr card_index_t
+cardIndex(const Card& card)
+{
+    if (card.isNull()) {
+        return NULL_INDEX;
+    }
+    if (card.isWild()) {
+        return WILDCARD_INDEX + card.id_.type_;
+    }
+    assert(unsigned(card.id_.seq_) < NCARDS && "Cards must come from g_deck");
+    return card.id_.seq_;
+}
+
+static constexpr const Card g_special_cards[] = { LOW_CARD, MEDIUM_CARD, HIGH_CARD, NULL_CARD };
+
+inline const Card&
+cardAt(card_index_t idx)
+{
+    assert(idx < NCARD_INDICES);
+    return (idx < NCARDS)? g_deck[idx] : g_special_cards[idx - NCARDS];
+}
+
+// A set of (non-wild) cards, with one bit per card index:
+using CardMask = std::bitset<NCARDS>;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// The undealt cards of a game: a shuffled stack of card indices per deck type,
+// with a pointer to its top, so drawing a card takes constant time.
+class Deck {
+  public:
+    // Shuffle all the game's cards:
+    explicit Deck(std::mt19937_64& prng);
+
+    // Stack up a shuffled collection of cards, keeping their order within each
+    // deck type (the first card of a type is the first one drawn):
+    explicit Deck(const Cards& shuffled);
+
+    // Draw the top card of a deck type, or NULL_CARD if none are left:
+    Card draw(deck_t dt)
+    {
+        return (top_[dt] == bottom_[dt])? NULL_CARD : g_deck[cards_[--top_[dt]]];
+    }
+
+    // How many cards of a deck type are left:
+    unsigned size(deck_t dt) const { return top_[dt] - bottom_[dt]; }
+
+  private:
+    card_index_t cards_[NCARDS];  // The stacks, one after the other, bottom cards first
+    unsigned bottom_[NDECKS];     // Where each stack starts in cards_
+    unsigned top_[NDECKS];        // Just past the top card of each stack
+};
+
+
+// The attributes of every card, by card index, in separate arrays (a structure
+// of arrays), so that code that scans many cards for one attribute (typically
+// their cost) only touches that attribute:
+struct CardTable {
+    constexpr CardTable();
+
+    Gems cost_[NCARD_INDICES];
+    gem_color_t color_[NCARD_INDICES];
+    points_t points_[NCARD_INDICES];
+    deck_t deck_[NCARD_INDICES];
+};
+
+constexpr CardTable::CardTable()
+  : cost_{}, color_{}, points_{}, deck_{}
+{
+    for (unsigned i = 0; i < NCARD_INDICES; ++i) {
+        const auto& card = (i < NCARDS)? g_deck[i] : g_special_cards[i - NCARDS];
+        cost_[i] = card.cost_;
+        color_[i] = card.color_;
+        points_[i] = card.points_;
+        deck_[i] = card.id_.type_;
+    }
+}
+
+extern const CardTable g_card_table;
+
+
+// The highest count of any color in any card's cost:
+constexpr gem_count_t
+maxCardCost()
+{
+    gem_count_t ret = 0;
+    for (const auto& card : g_deck) {
+        for (unsigned color = 0; color < NCOLOR - 1; ++color) {
+            ret = std::max(ret, card.cost_.getCount(gem_color_t(color)));
+        }
+    }
+    return ret;
+}
+
+static constexpr gem_count_t MAX_CARD_COST = maxCardCost();
+
+
+// For every (non-yellow) color and count, the cards that cost more than that
+// count of the color. Which cards a player can pay for is then a handful of mask
+// operations, however many cards there are to check.
+struct CostMasks {
+    CostMasks();
+
+    // The cards that some gems (typically a player's gems plus prestige) can't pay
+    // for, even with all their yellows making up for the shortage:
+    CardMask beyondReach(const Gems& gems) const;
+
+    CardMask above_[NCOLOR - 1][MAX_CARD_COST];
+};
+
+extern const CostMasks g_cost_masks;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// A pile of up to N cards (such as the table cards, or a player's reserves),
+// stored as card indices. It reads like a container of Cards, but it's changed
+// (by the board that owns it) through card indices and positions only.
+template <unsigned N>
+class CardPile {
+  public:
+    using Indices = StaticVector<card_index_t, N>;
+
+    class const_iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Card;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Card*;
+        using reference = const Card&;
+
+        explicit const_iterator(const card_index_t* idx) : idx_(idx) {}
+
+        reference operator*() const { return cardAt(*idx_); }
+        pointer operator->() const { return &cardAt(*idx_); }
+        const_iterator& operator++() { ++idx_; return *this; }
+        const_iterator operator++(int) { auto ret = *this; ++idx_; return ret; }
+        bool operator==(const const_iterator& rhs) const { return idx_ == rhs.idx_; }
+        bool operator!=(const const_iterator& rhs) const { return idx_ != rhs.idx_; }
+
+      private:
+        const card_index_t* idx_;
+    };
+    using iterator = const_iterator;
+
+    CardPile() = default;
+
+    // Copy a range of Cards:
+    template <typename Iter>
+    CardPile(Iter begin, Iter end)
+    {
+        for (auto iter = begin; iter != end; ++iter) {
+            indices_.push_back(cardIndex(*iter));
+        }
+    }
+
+    unsigned size() const { return indices_.size(); }
+    bool empty() const { return indices_.empty(); }
+
+    const_iterator begin() const { return const_iterator(indices_.begin()); }
+    const_iterator end() const { return const_iterator(indices_.end()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    const Card& operator[](unsigned pos) const { return cardAt(indices_[pos]); }
+    const Card& at(unsigned pos) const { return (*this)[pos]; }
+
+    const Indices& indices() const { return indices_; }
+    card_index_t index(unsigned pos) const { return indices_[pos]; }
+
+    // The position of a card in the pile (or -1 if it's not there):
+    int find(card_index_t idx) const
+    {
+        const auto where = std::find(indices_.begin(), indices_.end(), idx);
+        return (where == indices_.end())? -1 : int(where - indices_.begin());
+    }
+
+    void push_back(card_index_t idx) { indices_.push_back(idx); }
+    void pop_back() { indices_.pop_back(); }
+    void insert(unsigned pos, card_index_t idx) { indices_.insert(indices_.begin() + pos, idx); }
+    void erase(unsigned pos) { indices_.erase(indices_.begin() + pos); }
+    void replace(unsigned pos, card_index_t idx) { indices_[pos] = idx; }
+
+    bool operator==(const CardPile& rhs) const { return indices_ == rhs.indices_; }
+    bool operator!=(const CardPile& rhs) const { return indices_ != rhs.indices_; }
+
+  private:
+    Indices indices_;
+};
+
 } // namespace
\ No newline at end of file
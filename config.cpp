@@ -6,8 +6,11 @@
 #include "move.h"
 #include "move_notifier.h"
 #include "noble.h"
+#include "search_stats.h"
 
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <tbb/task_scheduler_init.h>
 
 namespace grandeur {
@@ -22,7 +25,7 @@ Config::Config(const std::vector<std::string>& args)
 
         if (*i == "-s" || *i == "--seed") {
             if (++i == args.cend()) die("missing seed value");
-            prng_.seed(atoll((i->c_str())));
+            seed_ = atoll((i->c_str()));
             continue;
         }
 
@@ -32,22 +35,46 @@ Config::Config(const std::vector<std::string>& args)
             continue;
         }
 
+        if (*i == "-m" || *i == "--move-ms") {
+            if (++i == args.cend()) die("missing milliseconds per move");
+            moveMillis_ = atoi((i->c_str()));
+            continue;
+        }
+
+        if (*i == "-n" || *i == "--games") {
+            if (++i == args.cend()) die("missing no. of games");
+            ngames_ = atoi((i->c_str()));
+            continue;
+        }
+
+        if (*i == "-c" || *i == "--csv") {
+            if (++i == args.cend()) die("missing filename");
+            csvFile_ = *i;
+            continue;
+        }
+
+        if (*i == "--stats") {
+            stats_ = true;
+            continue;
+        }
+
         if (*i == "-l" || *i == "--log") {
             if (++i == args.cend()) die("missing filename");
             loggerPtr_ = new Logger(*i);
-            MoveNotifier::instance().registerObserver(
-                    [=](MoveEvent event, const Board& board, player_id_t pid, const MoveNotifier::Payload& payload)
-                        { loggerPtr_->log(event, board, pid, payload); });
             continue;
         }
 
         // If we got here, we have an arbitrary string. Try to make Player:
         players_.push_back(PlayerFactory::instance().create(*i, players_.size()));
         if (nullptr == players_.back())   die ("unrecognized player " + *i);
+        playerNames_.push_back(*i);
     }
 
     if (!nthread_)  nthread_ = tbb::task_scheduler_init::default_num_threads();
     if (players_.size() < 2) die("must define at least two players");
+    if (players_.size() > size_t(MAX_NPLAYER)) die("too many players");
+    if (ngames_ && loggerPtr_) die("can't log tournament games");
+    if (!ngames_ && !csvFile_.empty()) die("game statistics are only collected in tournaments");
 }
 
 
@@ -61,6 +88,52 @@ Config::~Config()
 }
 
 
+/////////////////////////////////////////////////////////////
+// Search statistics are printed for every move, and totaled per player at the end.
+// They include timings, so they're only logged if requested too: a log of a game
+// is otherwise the same for the same seed.
+void
+Config::subscribe(MoveNotifier& notifier) const
+{
+    if (loggerPtr_) {
+        const auto logger = loggerPtr_;
+        const auto stats = stats_;
+        notifier.registerObserver(
+                [=](MoveEvent event, const Board& board, player_id_t pid, const MoveNotifier::Payload& payload)
+        {
+            if (stats || event != MoveEvent::MOVE_STATS) {
+                logger->log(event, board, pid, payload);
+            }
+        });
+    }
+
+    if (stats_) {
+        const auto totals = make_shared<vector<SearchStats>>(players_.size());
+        const auto nthread = nthread_;
+        notifier.registerObserver(
+                [=](MoveEvent event, const Board&, player_id_t pid, const MoveNotifier::Payload& payload)
+        {
+            if (event == MoveEvent::MOVE_STATS) {
+                cout << "Player " << pid << " searched: " << *payload.stats_ << "\n";
+                (*totals)[pid] += *payload.stats_;
+            } else if (event == MoveEvent::GAME_WON || event == MoveEvent::TIE) {
+                for (player_id_t p = 0; p < totals->size(); ++p) {
+                    const auto& total = (*totals)[p];
+                    if (total.moves_) {
+                        cout << "Player " << p << " searched " << total.moves_ << " moves: " << total;
+                        if (total.parallelism() > 0) {
+                            cout << ", parallel efficiency " << fixed << setprecision(2)
+                                 << total.parallelism() / nthread;
+                        }
+                        cout << "\n";
+                    }
+                }
+            }
+        });
+    }
+}
+
+
 /////////////////////////////////////////////////////////////
 void
 Config::die(const string msg) {
@@ -72,6 +145,10 @@ Config::die(const string msg) {
     cerr << "-s --seed num: Set PRNG seed for board generation\n";
     cerr << "-t --threads num: No. of threads to use (default: hardware threads)\n";
     cerr << "-l --log filename: Log board and moves to a file\n";
+    cerr << "-m --move-ms num: Time budget per move, in milliseconds, for players that support it\n";
+    cerr << "-n --games num: Play a tournament of num games (seeds starting from -s)\n";
+    cerr << "-c --csv filename: Write tournament game statistics to a CSV file\n";
+    cerr << "--stats: Report the search statistics of the players that collect them\n";
     cerr << "\nValid player choices are:";
     for (auto name : PlayerFactory::instance().names()) {
         cerr << "  " << name;
@@ -83,22 +160,22 @@ Config::die(const string msg) {
 
 
 Board
-Config::createBoard(Cards& deck)
+Config::createBoard(Deck& deck, mt19937_64& prng) const
 {
-    // Copy initial 12 cards to initial and remove from deck
+    // Draw the initial 12 cards from the deck
     Cards initialCards;
     for (int dt = LOW; dt <= HIGH; ++dt) {
         for (unsigned i = 0; i < INITIAL_DECK_NCARD; ++i) {
-            initialCards.push_back(popFromDeck(deck_t(dt), deck));
+            initialCards.push_back(deck.draw(deck_t(dt)));
         }
     }
 
     // Copy, shuffle, and truncate nobles
     vector<Noble> nobles(begin(g_nobles), end(g_nobles));
-    shuffle(begin(nobles), end(nobles), prng_);
+    shuffle(begin(nobles), end(nobles), prng);
     nobles.erase(nobles.begin() + g_noble_allocation[players_.size()], nobles.end());
 
-    return (Board(players_.size(), initialCards, nobles));
+    return (Board(players_.size(), initialCards, Board::Nobles(nobles.cbegin(), nobles.cend())));
 }
 
 
@@ -28,14 +28,22 @@ class Config {
     void die(const std::string msg = "");
 
     // Shuffle cards and nobles to create randomized game Board:
-    Board createBoard(Cards& deck);
+    Board createBoard(Deck& deck, std::mt19937_64& prng) const;
+
+    // Register the observers requested on the command line (e.g., a logger) for a game:
+    void subscribe(MoveNotifier& notifier) const;
 
     // Delete old player and replace with new ones:
     void resetPlayers(const Players& newPlayers);
 
-    std::mt19937_64 prng_; // A PRNG to initialize game state:
+    uint64_t seed_ = std::mt19937_64::default_seed;  // Seed of the (first) game
     Players players_;
+    std::vector<std::string> playerNames_;
     unsigned nthread_ = 0;  // No. of threads to run
+    unsigned ngames_ = 0;   // No. of games to play in a tournament (none if zero)
+    unsigned moveMillis_ = 0;  // Time budget per move (player's default if zero)
+    std::string csvFile_;   // Where to write tournament game statistics (if anywhere)
+    bool stats_ = false;    // Report the players' search statistics?
 
   private:
     Logger* loggerPtr_ = nullptr;
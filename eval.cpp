@@ -8,6 +8,7 @@
 #include <cmath>
 
 #include "eval.h"
+#include "fused_eval.h"
 #include "move.h"
 
 using namespace std;
@@ -51,10 +52,48 @@ operator*(score_t scalar, const Scores& scores)
 }
 
 //////////////////////////////////////////////////////////////
+// Which feature does an evaluation function score? (NFEATURES for any other evaluator)
+static Feature
+featureOf(const evaluator_t& evaluator)
+{
+    using function_t = Scores(*)(const Moves&, player_id_t, const Board&, const vector<Board>&);
+    static const function_t functions[NFEATURES] = {
+        winCondition, countPoints, countPrestige, countGems, countMoves,
+        monopolizeGems, preferWildcards, countReturns, preferShortGame, preferBuyTowardNoble
+    };
+
+    const auto target = evaluator.target<function_t>();
+    if (!target) {
+        return NFEATURES;
+    }
+    return Feature(distance(begin(functions), find(begin(functions), end(functions), *target)));
+}
+
+
+//////////////////////////////////////////////////////////////
+// The scores of evaluation functions are summed in the order they're listed, so
+// only evaluation functions listed in Feature order can be weighed as features.
+// Any other evaluators are summed one at a time.
 evaluator_t
 combine(const std::vector<evaluator_t>& evaluators, const std::vector<score_t>& weights)
 {
     assert(evaluators.size() == weights.size());
+
+    FeatureWeights featureWeights = {};
+    int last = -1;
+    bool batched = true;
+    for (size_t i = 0; i < evaluators.size() && batched; ++i) {
+        const auto feature = featureOf(evaluators[i]);
+        batched = (feature < NFEATURES && int(feature) > last);
+        if (batched) {
+            featureWeights[feature] = weights[i];
+            last = feature;
+        }
+    }
+    if (batched) {
+        return featureEvaluator(featureWeights);
+    }
+
     return [=](const Moves& moves,
         const player_id_t pid,
         const Board& curBoard,
@@ -62,7 +101,11 @@ combine(const std::vector<evaluator_t>& evaluators, const std::vector<score_t>&
     {
         Scores sums(moves.size(), 0);
         for (size_t i = 0; i < evaluators.size(); ++i) {
-            sums = sums + weights[i] * evaluators[i](moves, pid, curBoard, newBoards);
+            const auto scores = evaluators[i](moves, pid, curBoard, newBoards);
+            assert(scores.size() == sums.size());
+            for (unsigned j = 0; j < sums.size(); ++j) {
+                sums[j] += weights[i] * scores[j];
+            }
         }
         return sums;
     };
@@ -71,15 +114,14 @@ combine(const std::vector<evaluator_t>& evaluators, const std::vector<score_t>&
 
 //////////////////////////////////////////////////////////////
 Scores
-computeScores(const evaluator_t evaluator, const Moves& moves, const player_id_t pid,
+computeScores(const evaluator_t& evaluator, const Moves& moves, const player_id_t pid,
               const Board& curBoard, vector<Board>& newBoards)
 {
-    newBoards.clear();
-
-    for (const auto& mv : moves) {
-        newBoards.push_back(curBoard);
-        const auto status = makeMove(newBoards.back(), pid, mv, NULL_CARD);
+    newBoards.assign(moves.size(), curBoard);
+    for (unsigned i = 0; i < moves.size(); ++i) {
+        const auto status = makeMove(newBoards[i], pid, moves[i], NULL_CARD);
         assert(LEGAL_MOVE == status);
+        (void)status;
     }
 
     return evaluator(moves, pid, curBoard, newBoards);
@@ -87,87 +129,196 @@ computeScores(const evaluator_t evaluator, const Moves& moves, const player_id_t
 
 
 //////////////////////////////////////////////////////////////
-/// Evaluation functions
+Scores
+computeScores(const evaluator_t& evaluator, const Moves& moves, const player_id_t pid,
+              const Board& curBoard)
+{
+    static thread_local vector<Board> newBoards;
+    return computeScores(evaluator, moves, pid, curBoard, newBoards);
+}
+
+
+//////////////////////////////////////////////////////////////
+/// Batched evaluation
 //////////////////////////////////////////////////////////////
 
-Scores
-countPoints(const Moves& moves, const player_id_t pid, const Board& board,
-            const std::vector<Board>& newBoards)
+static score_t
+gemNumOfColor(const Board::TableCards& cards, gem_color_t color)
 {
-    Scores ret;
+    return count_if(cards.indices().cbegin(), cards.indices().cend(), [=](card_index_t idx)
+    {
+        return g_card_table.color_[idx] == color;
+    });
+}
+
+
+//////////////////////////////////////////////////////////////
+FeatureContext::FeatureContext(unsigned features, unsigned nmoves, player_id_t pid, const Board& curBoard)
+  : pid_(pid),
+    curPoints_(curBoard.playerPoints(pid)),
+    curGems_(curBoard.playerGems(pid).totalGems()),
+    nCards_(curBoard.tableCards().size()),
+    colorCount_{},
+    nobleCount_{},
+    nobleShare_(0),
+    mobility_(score_t(nmoves) / MEAN_MOVES),
+    gameLength_(std::log(1. + curBoard.roundNumber()) / std::log(1. / MAX_GAME_ROUNDS))
+{
+    if (features & (1u << RARITY)) {
+        for (unsigned color = 0; color < NCOLOR - 1; ++color) {
+            colorCount_[color] = gemNumOfColor(curBoard.tableCards(), gem_color_t(color));
+        }
+    }
+
+    if ((features & (1u << NOBLE_PROGRESS)) && !curBoard.tableNobles().empty()) {
+        nobleShare_ = 1. / curBoard.tableNobles().size();
+        for (unsigned color = 0; color < NCOLOR - 1; ++color) {
+            for (const auto& n : curBoard.tableNobles()) {
+                const auto nCost = n.cost_.getCount(gem_color_t(color));
+                if (nCost > 0
+                 && nCost > curBoard.playerPrestige(pid).getCount(gem_color_t(color))) {
+                    ++nobleCount_[color];
+                }
+            }
+        }
+    }
+}
+
+
+//////////////////////////////////////////////////////////////
+// Fill the contiguous values of one feature for all the moves:
+template <Feature F>
+static void
+fillFeature(const FeatureContext& ctx, const Moves& moves, const std::vector<Board>& newBoards,
+            score_t* values)
+{
+    for (unsigned i = 0; i < moves.size(); ++i) {
+        values[i] = featureValue<F>(ctx, moves[i], newBoards[i]);
+    }
+}
+
+
+//////////////////////////////////////////////////////////////
+void
+extractFeatures(const FeatureWeights& weights, const Moves& moves, const player_id_t pid,
+                const Board& curBoard, const std::vector<Board>& newBoards, MoveFeatures& features)
+{
+    using filler_t = void(*)(const FeatureContext&, const Moves&, const std::vector<Board>&, score_t*);
+    static const filler_t fillers[NFEATURES] = {
+        fillFeature<WINS>, fillFeature<POINT_GAIN>, fillFeature<PRESTIGE_GAIN>, fillFeature<GEM_GAIN>,
+        fillFeature<MOBILITY>, fillFeature<RARITY>, fillFeature<WILDCARDS>, fillFeature<RETURNS>,
+        fillFeature<GAME_LENGTH>, fillFeature<NOBLE_PROGRESS>
+    };
+
     assert(moves.size() == newBoards.size());
-    ret.reserve(newBoards.size());
-    const auto pts = board.playerPoints(pid);
+    unsigned wanted = 0;
+    for (unsigned feature = 0; feature < NFEATURES; ++feature) {
+        if (weights[feature] != 0) {
+            wanted |= 1u << feature;
+        }
+    }
 
-    transform(newBoards.cbegin(), newBoards.cend(), back_inserter(ret),
-              [=](const Board& board){ return board.playerPoints(pid) - pts; });
-    return ret;
+    const FeatureContext ctx(wanted, moves.size(), pid, curBoard);
+    features.size_ = moves.size();
+    for (unsigned feature = 0; feature < NFEATURES; ++feature) {
+        if (wanted & (1u << feature)) {
+            fillers[feature](ctx, moves, newBoards, features.values_[feature]);
+        }
+    }
 }
 
 
 //////////////////////////////////////////////////////////////
+// One multiply-add pass over contiguous scores per weighted feature, which the
+// compiler can vectorize, and no temporary score vectors:
 Scores
-countPrestige(const Moves& moves, const player_id_t pid, const Board& board,
-              const std::vector<Board>& newBoards)
+weighFeatures(const MoveFeatures& features, const FeatureWeights& weights)
 {
-    Scores ret;
-    ret.reserve(newBoards.size());
-    transform(moves.cbegin(), moves.cend(), back_inserter(ret),
-              [=](const GameMove& mv){ return (mv.type_ == MoveType::BUY_CARD)? 1 : 0; });
+    Scores ret(features.size_, 0.);
+    const auto sums = ret.begin();
+    for (unsigned feature = 0; feature < NFEATURES; ++feature) {
+        const auto weight = weights[feature];
+        if (weight != 0) {
+            const auto values = features.values_[feature];
+            for (unsigned i = 0; i < features.size_; ++i) {
+                sums[i] += weight * values[i];
+            }
+        }
+    }
     return ret;
 }
 
 
 //////////////////////////////////////////////////////////////
+evaluator_t
+featureEvaluator(const FeatureWeights& weights)
+{
+    return [=](const Moves& moves,
+        const player_id_t pid,
+        const Board& curBoard,
+        const std::vector<Board>& newBoards)
+    {
+        MoveFeatures features;
+        extractFeatures(weights, moves, pid, curBoard, newBoards, features);
+        return weighFeatures(features, weights);
+    };
+}
+
+
+//////////////////////////////////////////////////////////////
+/// Evaluation functions
+//////////////////////////////////////////////////////////////
+
+// Each evaluation function scores the moves by one feature:
+static Scores
+featureScores(Feature feature, const Moves& moves, const player_id_t pid, const Board& curBoard,
+              const std::vector<Board>& newBoards)
+{
+    FeatureWeights weights = {};
+    weights[feature] = 1;
+    MoveFeatures features;
+    extractFeatures(weights, moves, pid, curBoard, newBoards, features);
+    return Scores(features.values_[feature], features.values_[feature] + features.size_);
+}
+
+
 Scores
 winCondition(const Moves& moves, const player_id_t pid, const Board& curBoard,
              const std::vector<Board>& newBoards)
 {
-    Scores ret;
-    ret.reserve(newBoards.size());
-    transform(newBoards.cbegin(), newBoards.cend(), back_inserter(ret),
-              [=](const Board& board) {
-                  return (board.gameOver() && board.leadingPlayer() == pid)? 1 : 0;
-              });
-    return ret;
+    return featureScores(WINS, moves, pid, curBoard, newBoards);
 }
 
 
-//////////////////////////////////////////////////////////////
 Scores
-countGems(const Moves& moves, const player_id_t pid, const Board& curBoard,
-          const std::vector<Board>& newBoards)
+countPoints(const Moves& moves, const player_id_t pid, const Board& curBoard,
+            const std::vector<Board>& newBoards)
 {
-    const auto curGems = curBoard.playerGems(pid).totalGems();
-    Scores ret;
-    ret.reserve(newBoards.size());
-    transform(newBoards.cbegin(), newBoards.cend(), back_inserter(ret),
-              [=](const Board& board)
-              {
-                  return score_t(board.playerGems(pid).totalGems() - curGems)
-                         / DIFFERENT_COLOR_GEMS;
-              });
-    return ret;
+    return featureScores(POINT_GAIN, moves, pid, curBoard, newBoards);
 }
 
 
-//////////////////////////////////////////////////////////////
 Scores
-countMoves(const Moves& moves, const player_id_t pid, const Board& curBoard,
-           const std::vector<Board>& newBoards)
+countPrestige(const Moves& moves, const player_id_t pid, const Board& curBoard,
+              const std::vector<Board>& newBoards)
 {
-    return Scores(moves.size(), score_t(moves.size()) / MEAN_MOVES);
+    return featureScores(PRESTIGE_GAIN, moves, pid, curBoard, newBoards);
 }
 
 
-//////////////////////////////////////////////////////////////
-static score_t
-gemNumOfColor(const Cards& cards, gem_color_t color)
+Scores
+countGems(const Moves& moves, const player_id_t pid, const Board& curBoard,
+          const std::vector<Board>& newBoards)
 {
-    return count_if(cards.cbegin(), cards.cend(), [=](const Card& card)
-    {
-        return card.color_ == color;
-    });
+    return featureScores(GEM_GAIN, moves, pid, curBoard, newBoards);
+}
+
+
+Scores
+countMoves(const Moves& moves, const player_id_t pid, const Board& curBoard,
+           const std::vector<Board>& newBoards)
+{
+    return featureScores(MOBILITY, moves, pid, curBoard, newBoards);
 }
 
 
@@ -175,96 +326,142 @@ Scores
 monopolizeGems(const Moves& moves, const player_id_t pid, const Board& curBoard,
                const std::vector<Board>& newBoards)
 {
-    const auto nCards = curBoard.tableCards().size();
-    Scores ret;
-    ret.reserve(newBoards.size());
-    const score_t colorCount[] = {
-            gemNumOfColor(curBoard.tableCards(), WHITE),
-            gemNumOfColor(curBoard.tableCards(), TEAL),
-            gemNumOfColor(curBoard.tableCards(), GREEN),
-            gemNumOfColor(curBoard.tableCards(), RED),
-            gemNumOfColor(curBoard.tableCards(), BLACK)
-    };
-
-    transform(moves.cbegin(), moves.cend(), back_inserter(ret),
-              [=](const GameMove& mv)
-              {
-                  return (mv.type_ != MoveType::TAKE_GEMS
-                       && !mv.payload_.card_.isWild())?
-                         1. - colorCount[mv.payload_.card_.color_] / nCards
-                       : 0;
-              });
-    return ret;
+    return featureScores(RARITY, moves, pid, curBoard, newBoards);
 }
 
 
-//////////////////////////////////////////////////////////////
 Scores
 preferWildcards(const Moves& moves, const player_id_t pid, const Board& curBoard,
                 const std::vector<Board>& newBoards)
 {
-    Scores ret;
-    ret.reserve(newBoards.size());
-    transform(moves.cbegin(), moves.cend(), back_inserter(ret),
-              [=](const GameMove& mv)
-              {
-                  return (mv.type_ == MoveType::RESERVE_CARD
-                       && mv.payload_.card_.isWild())? 1 : 0.;
-              });
-    return ret;
+    return featureScores(WILDCARDS, moves, pid, curBoard, newBoards);
 }
 
 
-//////////////////////////////////////////////////////////////
 Scores
 countReturns(const Moves& moves, const player_id_t pid, const Board& curBoard,
              const std::vector<Board>& newBoards)
 {
-    Scores ret;
-    ret.reserve(newBoards.size());
-    transform(moves.cbegin(), moves.cend(), back_inserter(ret),
-              [=](const GameMove& mv)
-              {
-                  return (mv.type_ == MoveType::TAKE_GEMS
-                       && mv.payload_.gems_.hasNegatives())? 1 : 0;
-              });
-    return ret;
+    return featureScores(RETURNS, moves, pid, curBoard, newBoards);
 }
 
 
-//////////////////////////////////////////////////////////////
 Scores
 preferShortGame(const Moves& moves, const player_id_t pid, const Board& curBoard,
                 const std::vector<Board>& newBoards)
 {
-    return Scores(moves.size(),
-                  std::log(1. + curBoard.roundNumber()) / std::log(1. / MAX_GAME_ROUNDS));
+    return featureScores(GAME_LENGTH, moves, pid, curBoard, newBoards);
 }
 
 
-//////////////////////////////////////////////////////////////
 Scores
 preferBuyTowardNoble(const Moves& moves, const player_id_t pid, const Board& curBoard,
                      const std::vector<Board>& newBoards)
 {
-    Scores ret(moves.size(), 0.);
-    if (curBoard.tableNobles().empty()) {
+    return featureScores(NOBLE_PROGRESS, moves, pid, curBoard, newBoards);
+}
+
+
+//////////////////////////////////////////////////////////////
+/// Position evaluation
+//////////////////////////////////////////////////////////////
+
+position_evaluator_t
+combinePositions(const std::vector<position_evaluator_t>& evaluators, const std::vector<score_t>& weights)
+{
+    assert(evaluators.size() == weights.size());
+    return [=](const Board& board, const player_id_t pid)
+    {
+        score_t sum = 0;
+        for (size_t i = 0; i < evaluators.size(); ++i) {
+            sum += weights[i] * evaluators[i](board, pid);
+        }
+        return sum;
+    };
+}
+
+
+//////////////////////////////////////////////////////////////
+evaluator_t
+positionGain(const position_evaluator_t& eval)
+{
+    return [=](const Moves&,
+        const player_id_t pid,
+        const Board& curBoard,
+        const std::vector<Board>& newBoards)
+    {
+        const auto cur = eval(curBoard, pid);
+        Scores ret;
+        for (const auto& board : newBoards) {
+            ret.push_back(eval(board, pid) - cur);
+        }
         return ret;
+    };
+}
+
+
+//////////////////////////////////////////////////////////////
+score_t
+positionPoints(const Board& board, const player_id_t pid)
+{
+    return board.playerPoints(pid);
+}
+
+
+score_t
+positionPrestige(const Board& board, const player_id_t pid)
+{
+    return board.playerPrestige(pid).totalGems();
+}
+
+
+score_t
+positionWin(const Board& board, const player_id_t pid)
+{
+    return (board.gameOver() && board.leadingPlayer() == pid)? 1 : 0;
+}
+
+
+score_t
+positionGems(const Board& board, const player_id_t pid)
+{
+    return score_t(board.playerGems(pid).totalGems()) / DIFFERENT_COLOR_GEMS;
+}
+
+
+score_t
+positionMobility(const Board& board, const player_id_t pid)
+{
+    Moves moves;
+    legalMoves(board, pid, moves);
+    return score_t(moves.size()) / MEAN_MOVES;
+}
+
+
+score_t
+positionShortGame(const Board& board, const player_id_t)
+{
+    return std::log(1. + board.roundNumber()) / std::log(1. / MAX_GAME_ROUNDS);
+}
+
+
+// Every card of a color that a noble still needs brings the player 1/nobles closer:
+score_t
+positionNobleProgress(const Board& board, const player_id_t pid)
+{
+    const auto& nobles = board.tableNobles();
+    if (nobles.empty()) {
+        return 0;
     }
 
-    for (unsigned i = 0; i < moves.size(); ++i) {
-        if (moves[i].type_ == BUY_CARD) {
-            const auto color = moves[i].payload_.card_.color_;
-            for (const auto& n : curBoard.tableNobles()) {
-                const auto nCost = n.cost_.getCount(color);
-                if (nCost > 0
-                 && nCost > curBoard.playerPrestige(pid).getCount(color)) {
-                    ++ret[i];
-                }
-            }
+    const auto& prestige = board.playerPrestige(pid);
+    unsigned progress = 0;
+    for (const auto& n : nobles) {
+        for (unsigned color = 0; color < NCOLOR - 1; ++color) {
+            progress += min(n.cost_.getCount(gem_color_t(color)), prestige.getCount(gem_color_t(color)));
         }
     }
-    return (1. / curBoard.tableNobles().size()) * ret;
+    return score_t(progress) / nobles.size();
 }
 
-} // namespace
\ No newline at end of file
+} // namespace
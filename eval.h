@@ -8,18 +8,21 @@
 
 #pragma once
 
+#include <array>
 #include <functional>
 #include <vector>
 
 #include "board.h"
 #include "card.h"
 #include "move.h"
+#include "static_vector.h"
 
 namespace grandeur {
 
 using score_t = double;
 
-using Scores = std::vector<score_t>;
+// One score per legal move, stored in place (like Moves), so scoring never allocates:
+using Scores = StaticVector<score_t, MAX_LEGAL_MOVES>;
 
 Scores operator+(const Scores& lhs, const Scores& rhs);
 Scores operator-(const Scores& lhs, const Scores& rhs);
@@ -39,17 +42,62 @@ using evaluator_t = std::function<Scores(const Moves& moves,
 
 
 // Combine multiple evaluators to one evaluator, each with its own weight.
-// The combined evaluator sums all the weighted evaluators.
+// The combined evaluator sums all the weighted evaluators. When these are the
+// evaluation functions declared below, listed in Feature order, it returns the
+// equivalent featureEvaluator(), which scores all the moves in one batch.
 evaluator_t combine(const std::vector<evaluator_t>& evaluators,
                     const std::vector<score_t>& weights);
 
 
+///// Batched evaluation:
+// The features of a move that the evaluation functions below score, one each
+// (in the order they're declared):
+enum Feature {
+    WINS,            // winCondition
+    POINT_GAIN,      // countPoints
+    PRESTIGE_GAIN,   // countPrestige
+    GEM_GAIN,        // countGems
+    MOBILITY,        // countMoves
+    RARITY,          // monopolizeGems
+    WILDCARDS,       // preferWildcards
+    RETURNS,         // countReturns
+    GAME_LENGTH,     // preferShortGame
+    NOBLE_PROGRESS,  // preferBuyTowardNoble
+    NFEATURES
+};
+
+using FeatureWeights = std::array<score_t, NFEATURES>;
+
+// The features of a list of moves, as a structure of arrays: one contiguous
+// array of move scores per feature.
+struct MoveFeatures {
+    unsigned size_ = 0;  // No. of moves
+    score_t values_[NFEATURES][MAX_LEGAL_MOVES];
+};
+
+// Compute the features of every move that have a nonzero weight, in one pass
+// over the moves and the boards they lead to:
+void extractFeatures(const FeatureWeights& weights, const Moves& moves, const player_id_t pid,
+                     const Board& curBoard, const std::vector<Board>& newBoards, MoveFeatures& features);
+
+// The weighted sum of every move's features (in Feature order):
+Scores weighFeatures(const MoveFeatures& features, const FeatureWeights& weights);
+
+// An evaluator that extracts the features of all the moves, and then weighs them:
+evaluator_t featureEvaluator(const FeatureWeights& weights);
+
+
 // Compute scores for a given board state and evaluation function
 // It'll automatically generate and return the new boards and new legal moves for
 // each element of moves.
-Scores computeScores(const evaluator_t eval, const Moves& moves, const player_id_t pid, const Board& curBoard,
+Scores computeScores(const evaluator_t& eval, const Moves& moves, const player_id_t pid, const Board& curBoard,
                      std::vector<Board>& newBoards);
 
+// Same, for callers that don't need the new boards. These are then kept in a
+// per-thread buffer for the next call, so no memory is allocated once it warms up.
+// (Evaluators therefore mustn't call this version themselves.)
+Scores computeScores(const evaluator_t& eval, const Moves& moves, const player_id_t pid, const Board& curBoard);
+
 
 ////////////////////////////////////////////////////////////////////
 ////////// Declarations for various evaluation functions:
@@ -95,4 +143,52 @@ Scores preferBuyTowardNoble(const Moves& moves, const player_id_t pid, const Boa
                             const std::vector<Board>& newBoards);
 
 
+////////////////////////////////////////////////////////////////////
+///// Interface for a position (leaf) evaluator.
+// Scores a board for a player, no matter which moves led to it (higher is better).
+// Since it needs no other boards, a search only has to score the boards at its
+// leaves, and can store their scores in a transposition table.
+using position_evaluator_t = std::function<score_t(const Board& board, const player_id_t pid)>;
+
+// Combine multiple position evaluators to their weighted sum:
+position_evaluator_t combinePositions(const std::vector<position_evaluator_t>& evaluators,
+                                      const std::vector<score_t>& weights);
+
+// Score moves by how much each changes a position evaluator's score of the board,
+// so players that score moves can use position evaluators too:
+evaluator_t positionGain(const position_evaluator_t& eval);
+
+
+////////////////////////////////////////////////////////////////////
+////////// Declarations for position evaluation functions. The gain of each
+// from a move is the score of the move evaluation function it's named after,
+// unless noted otherwise. (countReturns, monopolizeGems, and preferWildcards
+// score moves, not boards, so they have no position form.)
+
+// The player's points (countPoints)
+score_t positionPoints(const Board& board, const player_id_t pid);
+
+// The player's prestige, i.e., no. of cards bought (countPrestige)
+score_t positionPrestige(const Board& board, const player_id_t pid);
+
+// One point if the game is over and the player leads it (winCondition)
+score_t positionWin(const Board& board, const player_id_t pid);
+
+// The player's gems, in units of a three-gem take (countGems)
+score_t positionGems(const Board& board, const player_id_t pid);
+
+// The player's no. of legal moves, relative to the average (countMoves scores
+// each move by the no. of moves before it, not after)
+score_t positionMobility(const Board& board, const player_id_t pid);
+
+// A penalty that grows with the round number (preferShortGame scores each move
+// by the round before it)
+score_t positionShortGame(const Board& board, const player_id_t pid);
+
+// The player's prestige toward every noble on the table, as a share of all the
+// nobles (preferBuyTowardNoble, except for the moves that win a noble, which
+// then leaves the table)
+score_t positionNobleProgress(const Board& board, const player_id_t pid);
+
+
 }  // namespace
\ No newline at end of file
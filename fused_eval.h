@@ -0,0 +1,123 @@
+// A compile-time combination of weighted features: a fused evaluator lists its
+// features and their weights as template arguments, so computing every move's
+// score is a single loop over the moves (and the boards they lead to), with all
+// the weighted terms inlined into it. Compare to combine(), which selects and
+// weighs its evaluators at run time, through std::function.
+//
+// Usage:
+//     const evaluator_t eval = FusedEvaluator<Term<WINS, 100>, Term<POINT_GAIN, 3, 2>>();
+//
+// The terms are summed in the order they're listed. Listed in Feature order, they
+// score moves exactly like combine() does with the same weights.
+//
+
+#pragma once
+
+#include "eval.h"
+
+#include <cassert>
+#include <initializer_list>
+
+namespace grandeur {
+
+// What the features of all the moves from one board have in common, computed
+// once per board. Only the features in the bit mask `features` are prepared.
+struct FeatureContext {
+    FeatureContext(unsigned features, unsigned nmoves, player_id_t pid, const Board& curBoard);
+
+    player_id_t pid_;
+    points_t curPoints_;           // The player's points before moving
+    int curGems_;                  // The player's gems before moving
+    score_t nCards_;               // No. of cards on the table
+    score_t colorCount_[NCOLOR];   // How many table cards give each color
+    score_t nobleCount_[NCOLOR];   // How many nobles still need more of each color
+    score_t nobleShare_;           // The share of each noble of all nobles
+    score_t mobility_;             // Same for all moves
+    score_t gameLength_;           // Same for all moves
+};
+
+
+// The value of one feature of one move, which leads to newBoard:
+template <Feature F>
+inline score_t
+featureValue(const FeatureContext& ctx, const GameMove& mv, const Board& newBoard)
+{
+    const auto type = mv.type();
+    const bool wild = (type != TAKE_GEMS && mv.card().isWild());
+    const auto color = (type != TAKE_GEMS && !wild)? g_card_table.color_[mv.index()] : YELLOW;
+
+    switch (F) {
+      case WINS:
+        return (newBoard.gameOver() && newBoard.leadingPlayer() == ctx.pid_)? 1 : 0;
+      case POINT_GAIN:
+        return newBoard.playerPoints(ctx.pid_) - ctx.curPoints_;
+      case PRESTIGE_GAIN:
+        return (type == BUY_CARD)? 1 : 0;
+      case GEM_GAIN:
+        return score_t(newBoard.playerGems(ctx.pid_).totalGems() - ctx.curGems_) / DIFFERENT_COLOR_GEMS;
+      case MOBILITY:
+        return ctx.mobility_;
+      case RARITY:
+        return (type != TAKE_GEMS && !wild)? 1. - ctx.colorCount_[color] / ctx.nCards_ : 0;
+      case WILDCARDS:
+        return (type == RESERVE_CARD && wild)? 1 : 0;
+      case RETURNS:
+        return (type == TAKE_GEMS && mv.gems().hasNegatives())? 1 : 0;
+      case GAME_LENGTH:
+        return ctx.gameLength_;
+      case NOBLE_PROGRESS:
+        return (type == BUY_CARD)? ctx.nobleCount_[color] * ctx.nobleShare_ : 0;
+      case NFEATURES:
+        break;
+    }
+    assert(false && "Unknown feature");
+    return 0;
+}
+
+
+// One weighted feature of a FusedEvaluator. Template arguments can't be
+// floating-point, so the weight is the fraction NUM / DEN:
+template <Feature F, int NUM, int DEN = 1>
+struct Term {
+    static_assert(F < NFEATURES, "Not a feature");
+    static_assert(DEN != 0, "Weight's denominator can't be zero");
+
+    static constexpr Feature feature() { return F; }
+    static constexpr score_t weight() { return score_t(NUM) / DEN; }
+};
+
+
+template <typename... Terms>
+class FusedEvaluator {
+    static_assert(sizeof...(Terms) > 0, "A fused evaluator needs at least one term");
+
+  public:
+    Scores operator()(const Moves& moves, const player_id_t pid, const Board& curBoard,
+                      const std::vector<Board>& newBoards) const
+    {
+        assert(moves.size() == newBoards.size());
+        const FeatureContext ctx(features(), moves.size(), pid, curBoard);
+        Scores ret(moves.size(), 0.);
+        for (unsigned i = 0; i < moves.size(); ++i) {
+            score_t sum = 0;
+            (void)std::initializer_list<int>{
+                (sum += Terms::weight() * featureValue<Terms::feature()>(ctx, moves[i], newBoards[i]), 0)...
+            };
+            ret[i] = sum;
+        }
+        return ret;
+    }
+
+  private:
+    // A bit mask of the features of all the terms:
+    static constexpr unsigned features()
+    {
+        unsigned mask = 0;
+        for (const auto f : { Terms::feature()... }) {
+            mask |= 1u << f;
+        }
+        return mask;
+    }
+};
+
+} // namespace
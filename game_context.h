@@ -0,0 +1,30 @@
+// GameContext: the state that belongs to a single game rather than to the whole
+// program. Every game gets its own context, passed through the game loop to the
+// players, so that concurrent games never share (or contend on) any of it.
+//
+// All of a game's randomness (shuffling the deck and nobles, random players)
+// is drawn from the context's PRNG, so a game is fully determined by its seed.
+// (Unless its players are limited by time rather than by the amount of work.)
+// Players that collect search statistics only time their searches if the
+// game reports them, since reading clocks all the time isn't free.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+namespace grandeur {
+
+struct GameContext {
+    explicit GameContext(uint64_t seed, unsigned moveMillis = 0, bool stats = false)
+      : prng_(seed), moveMillis_(moveMillis), stats_(stats)
+    {}
+
+    std::mt19937_64 prng_;
+    unsigned moveMillis_;  // Time budget per move, for players that can use one (zero for none)
+    bool stats_;           // Are the players' search statistics reported?
+    bool alone_ = true;    // Is this the only game running? (Else the process's CPU time isn't all ours)
+};
+
+} // namespace
@@ -11,6 +11,9 @@
 #include "constants.h"
 
 #include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
 #include <iosfwd>
 
@@ -24,11 +27,47 @@ static constexpr unsigned NCOLOR = 6;
 static constexpr char color2char[NCOLOR] = { 'W', 'T', 'G', 'R', 'B', 'Y' };
 
 
+// SIMD-within-a-register primitives, that treat a 64-bit word as eight signed
+// 8-bit lanes, and operate on all lanes at once without branches.
+namespace swar {
+
+static constexpr unsigned NLANES = 8;
+static constexpr uint64_t ONES = 0x0101010101010101ULL;  // Lowest bit of every lane
+static constexpr uint64_t HIGH = 0x8080808080808080ULL;  // Highest (sign) bit of every lane
+
+// Lane-wise addition and subtraction (wrapping around, like int8_t would):
+constexpr uint64_t add(uint64_t x, uint64_t y) { return ((x & ~HIGH) + (y & ~HIGH)) ^ ((x ^ y) & HIGH); }
+constexpr uint64_t sub(uint64_t x, uint64_t y) { return ((x | HIGH) - (y & ~HIGH)) ^ ((x ^ ~y) & HIGH); }
+
+// A mask of all the bits of every negative lane:
+constexpr uint64_t negative(uint64_t x) { return ((x & HIGH) >> 7) * 0xFF; }
+
+// The sign bit of every positive lane:
+constexpr uint64_t positive(uint64_t x) { return ((x & ~HIGH) + ~HIGH) & ~x & HIGH; }
+
+// How many lanes have their sign bit set:
+constexpr unsigned count(uint64_t signs) { return ((signs >> 7) * ONES) >> 56; }
+
+// The sum of all lanes (as signed numbers). Lanes are biased to be unsigned,
+// summed pairwise into 16-bit lanes, and then added together with a multiply:
+constexpr int sum(uint64_t x)
+{
+    return int((((((x ^ HIGH) & 0x00FF00FF00FF00FFULL) + (((x ^ HIGH) >> 8) & 0x00FF00FF00FF00FFULL))
+                * 0x0001000100010001ULL) >> 48) & 0xFFFF) - int(128 * NLANES);
+}
+
+} // namespace swar
+
+
+
 class Gems {
   public:
     // Catch-all constructor for gems
     template <typename... T>
-    constexpr Gems(T... args) : gems_{static_cast<gem_count_t>(args)...} {}
+    constexpr Gems(T... args) : gems_{static_cast<gem_count_t>(args)...}
+    {
+        static_assert(sizeof...(T) <= NCOLOR, "Too many gem colors");
+    }
 
     // Copy a range of gems (for iterator type only, not for a pair of args as above):
     template <typename Iter>
@@ -39,18 +78,22 @@ class Gems {
     int dec(gem_color_t color) { return --gems_[color]; }
 
     // How many gems we have in total (substracting negatives)
-    int totalGems() const;
+    int totalGems() const { return swar::sum(word()); }
 
     // How many different gem colors have positive quantities?
-    long positiveColors() const;
+    long positiveColors() const { return swar::count(swar::positive(word())); }
 
     // Does any gem color appear in negative quantities?
-    bool hasNegatives() const;
+    bool hasNegatives() const { return swar::negative(word()) != 0; }
 
     // What is the gem color with the highest gem quantity?
     gem_color_t maxColor() const;
 
-    gem_count_t getCount(gem_color_t color) const { return gems_.at(color); }
+    constexpr gem_count_t getCount(gem_color_t color) const
+    {
+        assert(color < NCOLOR);
+        return gems_[color];
+    }
 
     bool empty() const { return (positiveColors() == 0); }
 
@@ -60,33 +103,90 @@ class Gems {
     // are insufficient yellows.
     Gems actualCost(const Gems& target) const;
 
+    // Can these gems pay for target (which has no negative colors), with yellows
+    // making up for any shortage? This is !(*this - actualCost(target)).hasNegatives(),
+    // only cheaper.
+    bool canPay(const Gems& target) const;
+
     friend std::ostream& operator<<(std::ostream&, const Gems&);
 
 
-    Gems& operator+=(const Gems& rhs);
-    Gems& operator-=(const Gems& rhs);
+    Gems& operator+=(const Gems& rhs) { setWord(swar::add(word(), rhs.word())); return *this; }
+    Gems& operator-=(const Gems& rhs) { setWord(swar::sub(word(), rhs.word())); return *this; }
 
     friend Gems operator+(Gems lhs, const Gems& rhs) { lhs += rhs; return lhs; }
     friend Gems operator-(Gems lhs, const Gems& rhs) { lhs -= rhs; return lhs; }
 
-    bool operator==(const Gems& rhs) const { return gems_ == rhs.gems_; }
+    bool operator==(const Gems& rhs) const { return word() == rhs.word(); }
     bool operator!=(const Gems& rhs) const { return !(*this == rhs); }
 
   private:
-    std::array<gem_count_t, NCOLOR> gems_;
+    // All the gem counts, packed as the lanes of one 64-bit word:
+    uint64_t word() const
+    {
+        uint64_t ret;
+        std::memcpy(&ret, gems_.data(), sizeof(ret));
+        return ret;
+    }
+
+    void setWord(uint64_t word) { std::memcpy(gems_.data(), &word, sizeof(word)); }
+
+    // One lane per color, plus padding lanes, which are always zero:
+    std::array<gem_count_t, swar::NLANES> gems_;
 };
 
 template <typename Iter>
 Gems::Gems(Iter begin, Iter end, typename std::iterator_traits<Iter>::iterator_category*)
-  : gems_({ 0, 0, 0, 0, 0, 0 })
+  : gems_({ 0, 0, 0, 0, 0, 0, 0, 0 })
 {
     size_t i = 0;
     for (auto iter = begin; iter != end; ++iter) {
-        gems_.at(i++) = *iter;
+        assert(i < NCOLOR);
+        gems_[i++] = *iter;
     }
 }
 
 
+//////////////////////////////////////////////////////////////////////////////
+// Target may have negative-cost colors if we have "too much" discount.
+// Every color costs max(target, 0), of which we can pay at most what we have,
+// and we pay any shortage with yellows.
+inline Gems
+Gems::actualCost(const Gems& cost) const
+{
+    assert(!hasNegatives() && "Can't pay with negative gems");
+    assert(cost.gems_[YELLOW] == 0 && "Can't require a target with yellow");
+
+    const auto positiveCost = cost.word() & ~swar::negative(cost.word());
+    const auto diff = swar::sub(positiveCost, word());
+    const auto shortage = diff & ~swar::negative(diff);
+
+    Gems ret;
+    ret.setWord(positiveCost - shortage);  // No lane borrows, since shortage <= positiveCost
+    ret.gems_[YELLOW] = swar::sum(shortage);
+    return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+inline bool
+Gems::canPay(const Gems& target) const
+{
+    assert(!hasNegatives() && "Can't pay with negative gems");
+    assert(!target.hasNegatives() && "Can't pay for negative gems");
+    assert(target.gems_[YELLOW] == 0 && "Can't require a target with yellow");
+
+    // When we have enough of every color, no lane of (this + 128 - target) borrows
+    // from its sign bit:
+    if ((((word() | swar::HIGH) - target.word()) & swar::HIGH) == swar::HIGH) {
+        return true;
+    }
+
+    const auto diff = swar::sub(target.word(), word());
+    return swar::sum(diff & ~swar::negative(diff)) <= gems_[YELLOW];
+}
+
+
 // A mapping from the no. of players (2--4) to the initial table gem allocation:
 static constexpr const Gems g_gem_allocation[] = {
         Gems(),
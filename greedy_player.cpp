@@ -9,11 +9,12 @@
 namespace grandeur {
 
 GameMove
-GreedyPlayer::getMove(const Board& board, const Moves& legal) const
+GreedyPlayer::getMove(const Board& board, const Moves& legal, GameContext& context) const
 {
-    std::vector<Board> newBoards;
-    const auto scores = computeScores(evaluator_, legal, Player::pid_, board, newBoards);
-    const auto idx = distance(scores.cbegin(), max_element(scores.cbegin(), scores.cend()));
+    const MoveMeter meter(counters_, context);
+    const auto scores = scoreMoves(evaluator_, legal, Player::pid_, board, counters_);
+    const auto idx = std::distance(scores.cbegin(), std::max_element(scores.cbegin(), scores.cend()));
+    moveStats_ = meter.stats(1);
     return legal.at(idx);
 }
 
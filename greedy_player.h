@@ -8,6 +8,7 @@
 
 #include "player.h"
 #include "eval.h"
+#include "search_stats.h"
 
 namespace grandeur {
 
@@ -17,10 +18,14 @@ class GreedyPlayer final : public Player {
             : Player(pid), evaluator_(eval)
     {}
 
-    virtual GameMove getMove(const Board& board, const Moves& legal) const;
+    virtual GameMove getMove(const Board& board, const Moves& legal, GameContext& context) const;
+
+    virtual const SearchStats* moveStats() const { return &moveStats_; }
 
   private:
     evaluator_t evaluator_;
+    mutable SearchCounters counters_;
+    mutable SearchStats moveStats_;  // Of the last move
 };
 
 }  // namespace
@@ -3,6 +3,7 @@
 //
 
 #include "logger.h"
+#include "search_stats.h"
 
 #include <cassert>
 #include <fstream>
@@ -61,6 +62,10 @@ Logger::log(MoveEvent event, const Board& board, player_id_t pid,
     case MoveEvent::TIE:
         pImpl_->ofile_ << "GAME OVER! Stalemate!\n";
         break;
+
+    case MoveEvent::MOVE_STATS:
+        pImpl_->ofile_ << "Player " << pid << " searched: " << *payload.stats_ << "\n";
+        break;
     }
 }
 
@@ -14,10 +14,14 @@
 #include "move.h"
 #include "config.h"
 #include "board.h"
+#include "game_context.h"
+#include "move_notifier.h"
+#include "tournament.h"
 
 #include <tbb/task_scheduler_init.h>
 
 #include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -52,13 +56,33 @@ int main(int argc, char** argv)
     g_config = new Config(vector<string>(argv + 1, argv + argc));
     tbb::task_scheduler_init init(g_config->nthread_);
 
+    if (g_config->ngames_) {
+        Tournament tournament(*g_config);
+        if (g_config->csvFile_.empty()) {
+            tournament.run();
+        } else {
+            ofstream csv(g_config->csvFile_);
+            if (!csv) g_config->die("can't write to " + g_config->csvFile_);
+            tournament.run(&csv);
+        }
+        tournament.report(cout);
+        delete g_config;
+        return 0;
+    }
+
     // Create shuffled card deck:
-    Cards deck(begin(g_deck), end(g_deck));
-    shuffle(begin(deck), end(deck), g_config->prng_);
-    auto board = g_config->createBoard(deck);
-    MoveNotifier::instance().registerObserver(finalUpdate);
+    GameContext context(g_config->seed_, g_config->moveMillis_, g_config->stats_);
+    Deck deck(context.prng_);
+    auto board = g_config->createBoard(deck, context.prng_);
+
+    MoveNotifier notifier;
+    g_config->subscribe(notifier);
+    for (auto player : g_config->players_) {
+        player->subscribe(notifier);
+    }
+    notifier.registerObserver(finalUpdate);
 
-    mainGameLoop(board, deck, g_config->players_);
+    mainGameLoop(board, deck, g_config->players_, notifier, context);
 
     delete g_config;
     return 0;
@@ -0,0 +1,288 @@
+// Max^n and paranoid search players (see maxn_player.h)
+//
+
+#include "maxn_player.h"
+#include "game_context.h"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+using namespace std;
+
+namespace grandeur {
+
+static constexpr auto inf = numeric_limits<score_t>::infinity();
+
+// Utilities are computed with rounding errors, so shallow pruning requires the
+// previous player to be worse off by at least this much:
+static constexpr score_t PRUNING_MARGIN = 1e-9;
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// After the last player's turn, a new round starts (just like in mainGameLoop):
+static player_id_t
+nextTurn(player_id_t pid, Board& board)
+{
+    if (pid + 1 < board.playersNum()) {
+        return pid + 1;
+    }
+    board.newRound();
+    return 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+MaxnPlayer::MaxnPlayer(mode_t mode, unsigned maxDepth, const position_evaluator_t& eval, player_id_t pid)
+        : Player(pid), mode_(mode), depth_(maxDepth), evaluator_(eval)
+{
+    assert(maxDepth > 0 && "Minimum depth is one turn");
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// The root is searched like any other node, except that its moves are searched
+// in parallel, and that of several equally good moves, it picks the first.
+// Moves are searched with the best score found so far (by any task) as their
+// bound, or just below it for a move that comes before the best one, which may
+// still tie it.
+GameMove
+MaxnPlayer::getMove(const Board& board, const Moves& legal, GameContext& context) const
+{
+    const MoveMeter meter(counters_, context);
+    const auto pid = Player::pid_;
+    ++counters_.local().nodes_;
+
+    Board work = board;
+    ++counters_.local().boardCopies_;
+    const auto order = orderMoves(pid, depth_, work, legal);
+
+    mutex bestMutex;  // Guards bestIdx and bestScore
+    unsigned bestIdx = order.front();
+    auto bestScore = -inf;
+
+    const auto searchMove = [&](unsigned idx, Board& work) {
+        const auto undo = work.apply(pid, legal[idx]);
+        const auto next = nextTurn(pid, work);
+
+        unique_lock<mutex> lock(bestMutex);
+        const auto tieMargin = 1e-9 * (1 + std::abs(bestScore));
+        const auto bound = (idx < bestIdx)? bestScore - tieMargin : bestScore;
+        lock.unlock();
+        const auto score = (mode_ == MAXN)? maxn(next, depth_ - 1, work, bound)[pid]
+                                          : paranoid(next, depth_ - 1, work, bound, inf);
+        work.undo(undo);
+
+        lock.lock();
+        if (score > bestScore || (score == bestScore && idx < bestIdx)) {
+            bestScore = score;
+            bestIdx = idx;
+        }
+    };
+
+    searchMove(order.front(), work);
+    tbb::parallel_for(tbb::blocked_range<unsigned>(1, order.size()),
+                      [&](const tbb::blocked_range<unsigned>& range)
+    {
+        Board work = board;  // Each task walks its own copy of the board
+        auto& counts = counters_.local();
+        ++counts.tasks_;
+        ++counts.boardCopies_;
+        for (auto i = range.begin(); i != range.end(); ++i) {
+            searchMove(order[i], work);
+        }
+    });
+
+    moveStats_ = meter.stats(depth_);
+    return legal.at(bestIdx);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+MaxnPlayer::Utilities
+MaxnPlayer::utilities(const Board& board) const
+{
+    const auto nplayer = board.playersNum();
+    Utilities ret = {};
+    score_t total = 0;
+    for (player_id_t pid = 0; pid < nplayer; ++pid) {
+        ret[pid] = evaluator_(board, pid);
+        assert(ret[pid] >= 0 && "Max^n requires non-negative values");
+        total += ret[pid];
+    }
+
+    for (player_id_t pid = 0; pid < nplayer; ++pid) {
+        ret[pid] = (total > 0)? ret[pid] / total : 1. / nplayer;
+    }
+    return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+score_t
+MaxnPlayer::paranoidValue(const Board& board) const
+{
+    auto others = -inf;
+    for (player_id_t pid = 0; pid < board.playersNum(); ++pid) {
+        if (pid != Player::pid_) {
+            others = max(others, evaluator_(board, pid));
+        }
+    }
+    return evaluator_(board, Player::pid_) - others;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Sorting the moves pays off only where their boards aren't the leaves anyway.
+// Max^n keeps the moves in their order, which decides between moves that are
+// equally good for the player, but not for the others.
+MaxnPlayer::MoveOrder
+MaxnPlayer::orderMoves(player_id_t pid, unsigned depth, Board& board, const Moves& legal) const
+{
+    MoveOrder order;
+    for (unsigned i = 0; i < legal.size(); ++i) {
+        order.push_back(i);
+    }
+    if (mode_ == MAXN || depth <= 1) {
+        return order;
+    }
+
+    // The searching player tries the best moves for it first, the others the worst:
+    const score_t sign = (pid == Player::pid_)? 1 : -1;
+    Scores values;
+    for (const auto& mv : legal) {
+        const auto undo = board.apply(pid, mv);
+        nextTurn(pid, board);
+        values.push_back(sign * paranoidValue(board));
+        board.undo(undo);
+    }
+    sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+        return values[a] > values[b] || (values[a] == values[b] && a < b);
+    });
+    return order;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// The board is modified during the search, but restored before returning.
+MaxnPlayer::Utilities
+MaxnPlayer::maxn(player_id_t pid,          // The player making the current move
+                 unsigned depth,           // Depth of recursion (how many more turns)
+                 Board& board,             // Current board state
+                 score_t bound) const      // Utility the previous player has elsewhere
+{
+    auto& counts = counters_.local();
+    ++counts.nodes_;
+    if (depth == 0 || (pid == 0 && board.gameOver())) {
+        return utilities(board);
+    }
+    const auto legal = legalMoves(board, pid);
+    ++counts.legalMovesCalls_;
+    if (legal.empty()) {  // Pass (with no other move of pid to bound the next player)
+        Board work = board;
+        ++counts.boardCopies_;
+        const auto next = nextTurn(pid, work);
+        return maxn(next, depth - 1, work, -1);
+    }
+
+    Utilities best = {};
+    best[pid] = -1;  // Worse than any move
+    for (const auto& mv : legal) {
+        const auto undo = board.apply(pid, mv);
+        const auto next = nextTurn(pid, board);
+        const auto utils = maxn(next, depth - 1, board, best[pid]);
+        board.undo(undo);
+
+        if (utils[pid] > best[pid]) {
+            best = utils;
+        }
+        // Whatever else we find, the previous player gets at most 1 - best[pid]:
+        if (best[pid] >= 1 - bound + PRUNING_MARGIN) {
+            break;
+        }
+    }
+    return best;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Returns the value of the board if it falls within (alpha, beta), or a bound
+// on it otherwise (fail-soft). The searching player maximizes, the others minimize.
+// The board is modified during the search, but restored before returning.
+score_t
+MaxnPlayer::paranoid(player_id_t pid,       // The player making the current move
+                     unsigned depth,        // Depth of recursion (how many more turns)
+                     Board& board,          // Current board state
+                     score_t alpha,         // Value we're already guaranteed elsewhere
+                     score_t beta) const    // Value the opponents won't let us exceed
+{
+    auto& counts = counters_.local();
+    ++counts.nodes_;
+    if (depth == 0 || (pid == 0 && board.gameOver())) {
+        return paranoidValue(board);
+    }
+    const auto legal = legalMoves(board, pid);
+    ++counts.legalMovesCalls_;
+    if (legal.empty()) {  // Pass
+        Board work = board;
+        ++counts.boardCopies_;
+        const auto next = nextTurn(pid, work);
+        return paranoid(next, depth - 1, work, alpha, beta);
+    }
+
+    const bool maximize = (pid == Player::pid_);
+    auto best = maximize? -inf : inf;
+    for (const auto idx : orderMoves(pid, depth, board, legal)) {
+        const auto undo = board.apply(pid, legal[idx]);
+        const auto next = nextTurn(pid, board);
+        const auto value = paranoid(next, depth - 1, board, alpha, beta);
+        board.undo(undo);
+
+        if (maximize) {
+            best = max(best, value);
+            alpha = max(alpha, best);
+        } else {
+            best = min(best, value);
+            beta = min(beta, best);
+        }
+        if (alpha >= beta) {
+            break;
+        }
+    }
+    return best;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// The same position values as the negamax players':
+static const auto positionEval =
+        combinePositions({ positionWin, positionPoints, positionPrestige, positionGems, positionNobleProgress },
+                         { 100, 2, 1, 1, 2 });
+
+static PlayerFactory::Registrator regm2("maxn-2",
+        [](player_id_t pid){ return new MaxnPlayer(MaxnPlayer::MAXN, 2, positionEval, pid); });
+
+static PlayerFactory::Registrator regm3("maxn-3",
+        [](player_id_t pid){ return new MaxnPlayer(MaxnPlayer::MAXN, 3, positionEval, pid); });
+
+static PlayerFactory::Registrator regm4("maxn-4",
+        [](player_id_t pid){ return new MaxnPlayer(MaxnPlayer::MAXN, 4, positionEval, pid); });
+
+static PlayerFactory::Registrator regp2("paranoid-2",
+        [](player_id_t pid){ return new MaxnPlayer(MaxnPlayer::PARANOID, 2, positionEval, pid); });
+
+static PlayerFactory::Registrator regp3("paranoid-3",
+        [](player_id_t pid){ return new MaxnPlayer(MaxnPlayer::PARANOID, 3, positionEval, pid); });
+
+static PlayerFactory::Registrator regp4("paranoid-4",
+        [](player_id_t pid){ return new MaxnPlayer(MaxnPlayer::PARANOID, 4, positionEval, pid); });
+
+static PlayerFactory::Registrator regp5("paranoid-5",
+        [](player_id_t pid){ return new MaxnPlayer(MaxnPlayer::PARANOID, 5, positionEval, pid); });
+
+}  // namespace
@@ -0,0 +1,78 @@
+// Search players for any no. of players, who take turns around the table. They
+// score only the boards at the leaves of their search, for every player, with a
+// position evaluator (see eval.h), and back these scores up the tree one of two ways:
+//
+// Max^n: every player picks the move that's best for themselves. A player's
+// utility is their share of all the players' values, so utilities are never
+// negative and always sum to one (the evaluator mustn't return negative values).
+// That makes shallow pruning valid: once a player finds a move whose utility
+// leaves the previous player less than that player already has elsewhere, the
+// previous player won't move here, so the rest of the moves can be skipped.
+//
+// Paranoid: the searching player assumes that all the others play against it,
+// which makes it a two-sided game. A board's value is the player's own value minus
+// the best of the others', which it maximizes and they all minimize, so the search
+// can prune with alpha and beta (and try the likely best moves first). With two
+// players, these are the same values that NegamaxPlayer searches.
+//
+// Either way, like in the game loop, the game can only end with a round, so a
+// board where the game is over when it's player 0's turn is a leaf at any depth.
+// A player without moves passes the turn. The moves at the root are searched in
+// parallel TBB tasks, each with its own copy of the board.
+//
+
+#pragma once
+
+#include "player.h"
+#include "eval.h"
+#include "search_stats.h"
+
+#include <array>
+#include <cstdint>
+
+namespace grandeur {
+
+class MaxnPlayer final : public Player {
+  public:
+    enum mode_t { MAXN, PARANOID };
+
+    // Search maxDepth turns (of all the players, in turn) ahead:
+    MaxnPlayer(mode_t mode, unsigned maxDepth, const position_evaluator_t& eval, player_id_t pid);
+
+    virtual GameMove
+    getMove(const Board& board, const Moves& legal, GameContext& context) const;
+
+    // Total no. of search nodes (boards visited, leaves included) so far:
+    uint64_t nodesVisited() const { return counters_.read().nodes_; }
+
+    virtual const SearchStats* moveStats() const { return &moveStats_; }
+
+  private:
+    using Utilities = std::array<score_t, MAX_NPLAYER>;
+
+    // Every player's share of the players' total value of a board:
+    Utilities utilities(const Board& board) const;
+
+    // The value of a board for the searching player, against the best of the others:
+    score_t paranoidValue(const Board& board) const;
+
+    // The utilities of a board where pid is to move, unless the previous player
+    // can get more than bound elsewhere (then the result is only good enough to
+    // show that):
+    Utilities maxn(player_id_t pid, unsigned depth, Board& board, score_t bound) const;
+
+    // The paranoid value of a board where pid is to move (fail-soft alpha-beta):
+    score_t paranoid(player_id_t pid, unsigned depth, Board& board, score_t alpha, score_t beta) const;
+
+    // The indices of the legal moves, in the order to search them:
+    using MoveOrder = StaticVector<unsigned, MAX_LEGAL_MOVES>;
+    MoveOrder orderMoves(player_id_t pid, unsigned depth, Board& board, const Moves& legal) const;
+
+    mode_t mode_;
+    unsigned depth_;
+    position_evaluator_t evaluator_;
+    mutable SearchCounters counters_;
+    mutable SearchStats moveStats_;  // Of the last move
+};
+
+}  // namespace
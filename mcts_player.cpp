@@ -0,0 +1,394 @@
+// Monte Carlo Tree Search player (see mcts_player.h)
+//
+
+#include "mcts_player.h"
+#include "game_context.h"
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace grandeur {
+
+using Rewards = array<score_t, MAX_NPLAYER>;
+
+// How often greedy rollouts pick a random move instead, so that they don't all
+// play out the same way:
+static constexpr double GREEDY_EPSILON = 0.25;
+
+//////////////////////////////////////////////////////////////////////////////////
+// Pick a card that could still be in the undealt deck of a given type, uniformly.
+// Returns NULL_CARD if there are none.
+static Card
+sampleUndealt(const Board& board, deck_t dt, mt19937_64& prng)
+{
+    const auto undealt = board.undealtCards(dt);
+    if (undealt.none()) {
+        return NULL_CARD;
+    }
+
+    auto which = uniform_int_distribution<unsigned>(0, undealt.count() - 1)(prng);
+    for (unsigned idx = 0; idx < NCARDS; ++idx) {
+        if (undealt[idx] && !which--) {
+            return g_deck[idx];
+        }
+    }
+    assert(false && "Undealt card disappeared");
+    return NULL_CARD;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Make a move on a board, drawing any card it needs from the deck (just like
+// the game loop does), but with the hidden deck order sampled at random.
+static void
+playMove(Board& board, player_id_t pid, GameMove move, mt19937_64& prng)
+{
+    Card replacement = NULL_CARD;
+    if (move.type() != TAKE_GEMS) {
+        const auto& card = move.card();
+        if (card.isWild()) {
+            assert(move.type() == RESERVE_CARD);
+            move = GameMove(sampleUndealt(board, card.id_.type_, prng), RESERVE_CARD);
+            assert(!move.card().isNull());
+        } else if (board.isOnTable(card) && board.remainingCards(card.id_.type_) > 0) {
+            replacement = sampleUndealt(board, card.id_.type_, prng);
+        }
+    }
+
+    const auto status = makeMove(board, pid, move, replacement);
+    assert(status == LEGAL_MOVE);
+    (void)status;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Pass the turn to the next player, starting a new round after the last player.
+// Returns false if the game is over instead.
+template <unsigned NPLAYER>
+static bool
+nextTurn(FixedBoard<NPLAYER>& board, player_id_t& pid)
+{
+    if (++pid < NPLAYER) {
+        return true;
+    }
+    if (board.gameOver()) {
+        return false;
+    }
+    board.newRound();
+    pid = 0;
+    return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// The outcome of a game for each player: one for a win, and a tie shared equally
+// among the leading players.
+template <unsigned NPLAYER>
+static Rewards
+gameRewards(const FixedBoard<NPLAYER>& board)
+{
+    Rewards ret = {};
+    points_t maxPoints = 0;
+    unsigned nleaders = 0;
+    for (player_id_t pid = 0; pid < NPLAYER; ++pid) {
+        if (board.playerPoints(pid) > maxPoints) {
+            maxPoints = board.playerPoints(pid);
+            nleaders = 0;
+        }
+        nleaders += (board.playerPoints(pid) == maxPoints);
+    }
+    for (player_id_t pid = 0; pid < NPLAYER; ++pid) {
+        ret[pid] = (board.playerPoints(pid) == maxPoints)? 1. / nleaders : 0;
+    }
+    return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// A single search tree, grown by one node per iteration. Its iterations play
+// whole games, so its boards have a fixed no. of players.
+template <unsigned NPLAYER>
+class MctsPlayer::Tree {
+  public:
+    Tree(const MctsPlayer& player, const Board& board, const Moves& legal, uint64_t seed)
+      : player_(player), root_(board), rootMoves_(legal), prng_(seed), nodes_(1)
+    {}
+
+    // Select a path down the tree, add a node for a new move at its end,
+    // play the rest of the game out from there, and update the path's scores.
+    void iterate();
+
+    // How many times each root move was visited:
+    vector<unsigned> rootVisits() const;
+
+    // The length of the longest path from the root:
+    unsigned depth() const { return depth_; }
+
+    // The work of all iterations so far:
+    const SearchCounters::Counts& counts() const { return counts_; }
+
+  private:
+    struct Node {
+        GameMove move_ = NULL_MOVE;   // The move leading to this node
+        player_id_t mover_ = 0;       // The player who made it
+        unsigned visits_ = 0;         // No. of iterations that went through this node
+        unsigned available_ = 0;      // No. of visits to the parent where move_ was legal
+        score_t reward_ = 0;          // Total outcome of these visits for mover_
+        vector<unsigned> children_;   // Indices of child nodes in nodes_
+    };
+
+    // Play out the rest of a game according to the rollout policy:
+    void rollout(FixedBoard<NPLAYER>& board, player_id_t pid);
+
+    const MctsPlayer& player_;
+    const Board& root_;
+    const Moves& rootMoves_;
+    mt19937_64 prng_;
+    vector<Node> nodes_;     // nodes_[0] is the root
+    vector<unsigned> path_;  // Nodes of the current iteration
+    Moves untried_;          // Legal moves of the current node with no children yet
+    unsigned depth_ = 0;
+    SearchCounters::Counts counts_;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+template <unsigned NPLAYER>
+void
+MctsPlayer::Tree<NPLAYER>::iterate()
+{
+    FixedBoard<NPLAYER> board(root_);
+    ++counts_.nodes_;
+    ++counts_.boardCopies_;
+    player_id_t pid = player_.pid_;
+    unsigned cur = 0;
+    path_.assign(1, cur);
+
+    bool live = true;
+    Moves legal;
+    while (live) {
+        if (cur) {
+            legalMoves(board, pid, legal);
+            ++counts_.legalMovesCalls_;
+        }
+        const auto& moves = cur? legal : rootMoves_;
+        if (moves.empty()) {  // Skip the turn of a player who can't move
+            live = nextTurn(board, pid);
+            continue;
+        }
+
+        // Find the best child among the legal moves, and the moves without one:
+        untried_.clear();
+        unsigned best = 0;
+        auto bestScore = -numeric_limits<score_t>::infinity();
+        for (const auto& move : moves) {
+            const auto& children = nodes_[cur].children_;
+            const auto where = find_if(children.cbegin(), children.cend(), [&](unsigned c) {
+                return nodes_[c].mover_ == pid && nodes_[c].move_ == move;
+            });
+            if (where == children.cend()) {
+                untried_.push_back(move);
+                continue;
+            }
+            auto& child = nodes_[*where];
+            ++child.available_;
+            const auto score = child.reward_ / child.visits_
+                             + player_.exploration_ * sqrt(log(child.available_) / child.visits_);
+            if (score > bestScore) {
+                bestScore = score;
+                best = *where;
+            }
+        }
+
+        // Expand a new node if there are untried moves, and continue with a rollout:
+        if (!untried_.empty()) {
+            Node child;
+            child.move_ = untried_[uniform_int_distribution<unsigned>(0, untried_.size() - 1)(prng_)];
+            child.mover_ = pid;
+            child.available_ = 1;
+            nodes_.push_back(child);
+            nodes_[cur].children_.push_back(nodes_.size() - 1);
+            path_.push_back(nodes_.size() - 1);
+            playMove(board, pid, child.move_, prng_);
+            live = nextTurn(board, pid);
+            break;
+        }
+
+        cur = best;
+        path_.push_back(cur);
+        playMove(board, pid, nodes_[cur].move_, prng_);
+        live = nextTurn(board, pid);
+    }
+
+    depth_ = max<unsigned>(depth_, path_.size() - 1);
+    if (live) {
+        rollout(board, pid);
+    }
+
+    const auto rewards = gameRewards(board);
+    ++nodes_[0].visits_;
+    for (auto it = path_.cbegin() + 1; it != path_.cend(); ++it) {
+        auto& node = nodes_[*it];
+        ++node.visits_;
+        node.reward_ += rewards[node.mover_];
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+template <unsigned NPLAYER>
+void
+MctsPlayer::Tree<NPLAYER>::rollout(FixedBoard<NPLAYER>& board, player_id_t pid)
+{
+    do {
+        const auto legal = legalMoves(board, pid);
+        ++counts_.legalMovesCalls_;
+        if (legal.empty()) {
+            continue;
+        }
+
+        unsigned idx = 0;
+        if (player_.rollout_ == GREEDY_ROLLOUT && uniform_real_distribution<>()(prng_) >= GREEDY_EPSILON) {
+            const auto start = player_.counters_.timed_? chrono::steady_clock::now()
+                                                       : chrono::steady_clock::time_point();
+            const auto scores = computeScores(player_.evaluator_, legal, pid, board);
+            if (player_.counters_.timed_) {
+                counts_.evalNanos_ += chrono::duration_cast<chrono::nanoseconds>(
+                        chrono::steady_clock::now() - start).count();
+            }
+            counts_.boardCopies_ += legal.size();
+            idx = distance(scores.cbegin(), max_element(scores.cbegin(), scores.cend()));
+        } else {
+            idx = uniform_int_distribution<unsigned>(0, legal.size() - 1)(prng_);
+        }
+        playMove(board, pid, legal[idx], prng_);
+    } while (nextTurn(board, pid));
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+template <unsigned NPLAYER>
+vector<unsigned>
+MctsPlayer::Tree<NPLAYER>::rootVisits() const
+{
+    vector<unsigned> ret(rootMoves_.size(), 0);
+    for (const auto c : nodes_[0].children_) {
+        const auto where = find(rootMoves_.cbegin(), rootMoves_.cend(), nodes_[c].move_);
+        assert(where != rootMoves_.cend());
+        ret[distance(rootMoves_.cbegin(), where)] = nodes_[c].visits_;
+    }
+    return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+MctsPlayer::MctsPlayer(unsigned iterations, unsigned millis, rollout_t rollout, const evaluator_t& eval,
+                       player_id_t pid, unsigned ntrees, score_t exploration)
+  : Player(pid), maxIterations_(iterations), millis_(millis), rollout_(rollout), evaluator_(eval),
+    ntrees_(ntrees? ntrees : tbb::task_scheduler_init::default_num_threads()),
+    exploration_(exploration)
+{
+    assert((iterations || millis) && "MCTS needs a budget of iterations or time");
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Every tree gets the full budget of iterations, and the move that was visited
+// the most in all of them is chosen (ties go to the first move).
+GameMove
+MctsPlayer::getMove(const Board& board, const Moves& legal, GameContext& context) const
+{
+    assert(!legal.empty());
+    const MoveMeter meter(counters_, context);
+    if (legal.size() == 1) {
+        moveStats_ = meter.stats(0);
+        total_ += moveStats_;
+        return legal.front();
+    }
+
+    const auto maxIterations = context.moveMillis_? 0 : maxIterations_;
+    const auto millis = context.moveMillis_? context.moveMillis_ : millis_;
+    const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(millis);
+    const auto seed = context.prng_();
+    vector<vector<unsigned>> visits(ntrees_);
+    vector<unsigned> depths(ntrees_);
+
+    // Each tree counts its own work, and adds it to the thread's counts at the end:
+    withPlayers(board.playersNum(), [&](auto nplayer) {
+        tbb::parallel_for(0u, ntrees_, [&](unsigned t) {
+            Tree<decltype(nplayer)::value> tree(*this, board, legal, seed + t);
+            unsigned n = 0;
+            while ((!maxIterations || n < maxIterations) && (!millis || chrono::steady_clock::now() < deadline)) {
+                tree.iterate();
+                ++n;
+            }
+            visits[t] = tree.rootVisits();
+            depths[t] = tree.depth();
+
+            auto& counts = counters_.local();
+            counts.nodes_ += tree.counts().nodes_;
+            counts.legalMovesCalls_ += tree.counts().legalMovesCalls_;
+            counts.boardCopies_ += tree.counts().boardCopies_;
+            counts.evalNanos_ += tree.counts().evalNanos_;
+            ++counts.tasks_;
+        });
+    });
+
+    vector<unsigned> total(legal.size(), 0);
+    for (const auto& tv : visits) {
+        for (unsigned i = 0; i < tv.size(); ++i) {
+            total[i] += tv[i];
+        }
+    }
+
+    moveStats_ = meter.stats(*max_element(depths.cbegin(), depths.cend()));
+    total_ += moveStats_;
+    return legal.at(distance(total.cbegin(), max_element(total.cbegin(), total.cend())));
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+static const auto greedyEval =
+        combine({ winCondition, countPoints, countPrestige },
+                { 100,          2,           1 } );
+
+// The levels always grow four trees, in parallel on up to four cores, so that
+// their strength (and their moves, for a given seed) don't depend on the machine
+// they run on. Random rollouts are cheap, so the levels start at 250 iterations
+// per tree and double up:
+static constexpr unsigned LEVEL_TREES = 4;
+
+static PlayerFactory::Registrator reg1("mcts-1",
+        [](player_id_t pid){ return new MctsPlayer(250, 0, MctsPlayer::RANDOM_ROLLOUT, greedyEval, pid, LEVEL_TREES); });
+static PlayerFactory::Registrator reg2("mcts-2",
+        [](player_id_t pid){ return new MctsPlayer(500, 0, MctsPlayer::RANDOM_ROLLOUT, greedyEval, pid, LEVEL_TREES); });
+static PlayerFactory::Registrator reg3("mcts-3",
+        [](player_id_t pid){ return new MctsPlayer(1000, 0, MctsPlayer::RANDOM_ROLLOUT, greedyEval, pid, LEVEL_TREES); });
+static PlayerFactory::Registrator reg4("mcts-4",
+        [](player_id_t pid){ return new MctsPlayer(2000, 0, MctsPlayer::RANDOM_ROLLOUT, greedyEval, pid, LEVEL_TREES); });
+static PlayerFactory::Registrator reg5("mcts-5",
+        [](player_id_t pid){ return new MctsPlayer(4000, 0, MctsPlayer::RANDOM_ROLLOUT, greedyEval, pid, LEVEL_TREES); });
+
+// Greedy rollouts are much slower, but also much closer to real play:
+static PlayerFactory::Registrator reg6("mcts-greedy-1",
+        [](player_id_t pid){ return new MctsPlayer(50, 0, MctsPlayer::GREEDY_ROLLOUT, greedyEval, pid, LEVEL_TREES); });
+static PlayerFactory::Registrator reg7("mcts-greedy-2",
+        [](player_id_t pid){ return new MctsPlayer(100, 0, MctsPlayer::GREEDY_ROLLOUT, greedyEval, pid, LEVEL_TREES); });
+static PlayerFactory::Registrator reg8("mcts-greedy-3",
+        [](player_id_t pid){ return new MctsPlayer(200, 0, MctsPlayer::GREEDY_ROLLOUT, greedyEval, pid, LEVEL_TREES); });
+static PlayerFactory::Registrator reg9("mcts-greedy-4",
+        [](player_id_t pid){ return new MctsPlayer(400, 0, MctsPlayer::GREEDY_ROLLOUT, greedyEval, pid, LEVEL_TREES); });
+static PlayerFactory::Registrator reg10("mcts-greedy-5",
+        [](player_id_t pid){ return new MctsPlayer(800, 0, MctsPlayer::GREEDY_ROLLOUT, greedyEval, pid, LEVEL_TREES); });
+
+}  // namespace
@@ -0,0 +1,77 @@
+// A Monte Carlo Tree Search player, using UCT (upper confidence bounds applied to
+// trees). Instead of scoring boards with an evaluator, it plays many games from
+// the current board to the end ("rollouts"), and gradually focuses the search on
+// the moves that win most often. Unlike minimax, it works for any no. of players:
+// every node keeps the score of the player who made the move leading to it.
+//
+// The cards in the undealt decks are hidden, so whenever a simulated move needs
+// a card from a deck (a replacement for a table card, or a wildcard reserve), a
+// card is sampled from those that could still be there. Since different samples
+// lead to different legal moves, each tree node also counts how often its move
+// was available, and uses that count in place of its parent's visits.
+//
+// The search is parallelized by growing several independent trees in TBB tasks,
+// each with its own PRNG (seeded from the game's), and adding up their root
+// statistics. A budget of iterations is per tree, so more trees never leave each
+// one with thinner statistics, and the chosen move depends only on the no. of
+// trees, not on how many threads grow them. With a budget of milliseconds it
+// depends on the machine's speed.
+// In its search statistics, every iteration counts as a node (it adds one to a
+// tree), every tree as a task, and the depth is that of the deepest tree. Moves
+// aren't scored at the nodes, so there's no branching factor.
+//
+
+#pragma once
+
+#include "player.h"
+#include "eval.h"
+#include "search_stats.h"
+
+#include <cstdint>
+
+namespace grandeur {
+
+class MctsPlayer final : public Player {
+  public:
+    // How to pick the moves of a rollout:
+    enum rollout_t {
+        RANDOM_ROLLOUT,  // Any legal move
+        GREEDY_ROLLOUT   // The move the evaluator scores highest
+    };
+
+    // Default weight of exploration vs. exploitation in UCT:
+    static constexpr score_t DEFAULT_EXPLORATION = 1.4;
+
+    // Each move is searched for the given no. of iterations (rollouts) per tree
+    // or the given no. of milliseconds, whichever runs out first. Zero means no
+    // limit, but at least one of them must be set. A time budget in the game
+    // context replaces both. The evaluator is only used for greedy rollouts.
+    // ntrees is the no. of independent trees (default: one per thread).
+    MctsPlayer(unsigned iterations, unsigned millis, rollout_t rollout, const evaluator_t& eval,
+               player_id_t pid, unsigned ntrees = 0, score_t exploration = DEFAULT_EXPLORATION);
+
+    virtual GameMove
+    getMove(const Board& board, const Moves& legal, GameContext& context) const;
+
+    // Total no. of iterations and search time of all moves so far, to size hardware:
+    uint64_t iterations() const { return total_.nodes_; }
+    double seconds() const { return total_.wallSeconds_; }
+    double iterationsPerSecond() const { return total_.nodesPerSecond(); }
+
+    virtual const SearchStats* moveStats() const { return &moveStats_; }
+
+  private:
+    template <unsigned NPLAYER> class Tree;
+
+    unsigned maxIterations_;
+    unsigned millis_;
+    rollout_t rollout_;
+    evaluator_t evaluator_;
+    unsigned ntrees_;
+    score_t exploration_;
+    mutable SearchCounters counters_;
+    mutable SearchStats moveStats_;  // Of the last move
+    mutable SearchStats total_;      // Of all moves so far
+};
+
+}  // namespace
@@ -3,21 +3,75 @@
 //
 
 #include "minimax_player.h"
+#include "fused_eval.h"
+#include "game_context.h"
 
+#include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <random>
 
 using namespace std;
 
 namespace grandeur {
 
 
+//////////////////////////////////////////////////////////////////////////////////
+// Does a move draw a card from its deck? (It does when it takes a card off the
+// table, or reserves a card from the deck, as long as the deck isn't empty.)
+static bool
+drawsCard(const Board& board, const GameMove& move)
+{
+    if (move.type() == TAKE_GEMS) {
+        return false;
+    }
+    const auto& card = move.card();
+    return (card.isWild() || board.isOnTable(card)) && board.remainingCards(card.id_.type_) > 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Pick up to n different cards that could still be in the undealt deck of a given
+// type, uniformly, or all of them if there are no more than n.
+static Cards
+sampleUndealt(const Board& board, deck_t dt, unsigned n, uint64_t seed)
+{
+    const auto undealt = board.undealtCards(dt);
+    Cards ret;
+    for (unsigned idx = 0; idx < NCARDS; ++idx) {
+        if (undealt[idx]) {
+            ret.push_back(g_deck[idx]);
+        }
+    }
+    if (ret.size() <= n) {
+        return ret;
+    }
+
+    // Partial Fisher-Yates shuffle:
+    mt19937_64 prng(seed);
+    for (unsigned i = 0; i < n; ++i) {
+        swap(ret[i], ret[uniform_int_distribution<size_t>(i, ret.size() - 1)(prng)]);
+    }
+    ret.erase(ret.begin() + n, ret.end());
+    return ret;
+}
+
+
 //////////////////////////////////////////////////////////////////////////////////
 MinimaxPlayer::MinimaxPlayer(unsigned maxDepth, const evaluator_t& eval, player_id_t pid,
-                             score_t agingWeight)
-        : Player(pid), depth_(maxDepth), evaluator_(eval), agingWeight_(agingWeight)
+                             score_t agingWeight, unsigned ttSizeLog2, unsigned chanceSamples)
+        : Player(pid), depth_(maxDepth), evaluator_(eval), agingWeight_(agingWeight),
+          chanceSamples_(chanceSamples), tt_(ttSizeLog2), chanceTT_(chanceSamples? ttSizeLog2 : 0)
 {
     assert(maxDepth > 0 && "Minimum depth is one turn");
 }
@@ -25,40 +79,42 @@ MinimaxPlayer::MinimaxPlayer(unsigned maxDepth, const evaluator_t& eval, player_
 
 //////////////////////////////////////////////////////////////////////////////////
 GameMove
-MinimaxPlayer::getMove(const Board& board, const Moves& legal) const
+MinimaxPlayer::getMove(const Board& board, const Moves& legal, GameContext& context) const
 {
     assert(board.playersNum() == 2 && "Minimax only defined for two players");
-    const auto bestMove = bestMoveN(Player::pid_, depth_, board, legal).first;
+    const MoveMeter meter(counters_, context);
+    Board work = board;
+    ++counters_.local().boardCopies_;
+    const auto bestMove = bestMoveN(Player::pid_, depth_, work, legal).first;
+    moveStats_ = meter.stats(depth_);
     return legal.at(bestMove);
 }
 
 //////////////////////////////////////////////////////////////////////////////////
 // The first element of the return value is the index of the best move.
 // The second element of the return value is the cumulative score of the best move.
+// The board is modified during the search, but restored before returning.
 std::pair<unsigned, score_t>
 MinimaxPlayer::bestMoveN(player_id_t pid,          // The player making the current move
                          unsigned depth,           // Depth of recursion (how many more turns)
-                         const Board& board,       // Current board state
+                         Board& board,             // Current board state
                          const Moves& legal) const // List of current legal movees
 {
-    vector<Board> newBoards;
     assert(!legal.empty());
 
-    auto scores = depth * agingWeight_ *
-            computeScores(evaluator_, legal, pid, board, newBoards);
+    auto scores = depth * agingWeight_ * scoreMoves(evaluator_, legal, pid, board, counters_);
     if (depth > 1) {
-        tbb::parallel_for(0, int(legal.size()), 1, [&](auto idx)
-// sequential        for (unsigned idx = 0; idx < legal.size(); ++idx)
+        tbb::parallel_for(tbb::blocked_range<unsigned>(0, legal.size()),
+                          [&](const tbb::blocked_range<unsigned>& range)
         {
-            if (pid == 0) {
-                newBoards[idx].newRound();
-            }
-
-            // Swap out pid for opponent:
-            const auto opMoves = legalMoves(newBoards[idx], 1 - pid);
-            if (!opMoves.empty()) {
-                const auto best = this->bestMoveN(1 - pid, depth - 1, newBoards[idx], opMoves);
-                scores[idx] -= best.second;
+            Board work = board;  // Each task walks its own copy of the board
+            auto& counts = counters_.local();
+            ++counts.tasks_;
+            ++counts.boardCopies_;
+            for (auto idx = range.begin(); idx != range.end(); ++idx) {
+                scores[idx] -= (chanceSamples_ && drawsCard(work, legal[idx]))
+                             ? chanceScore(pid, depth, work, legal[idx])
+                             : replyScore(pid, depth, work, legal[idx], NULL_CARD);
             }
         }
         );
@@ -70,19 +126,630 @@ MinimaxPlayer::bestMoveN(player_id_t pid,          // The player making the curr
 
 
 //////////////////////////////////////////////////////////////////////////////////
-static const auto comboEval =
-        combine({ winCondition, countPoints, countPrestige },
-                { 100,          2,           1 } );
+// The board is modified during the search, but restored before returning.
+score_t
+MinimaxPlayer::replyScore(player_id_t pid, unsigned depth, Board& board, const GameMove& move,
+                          const Card& replacement) const
+{
+    const auto undo = board.apply(pid, move, replacement);
+    if (pid == 0) {
+        board.newRound();
+    }
+
+    // Swap out pid for opponent, unless we've already seen this board:
+    score_t ret = 0;
+    const auto key = board.hash(1 - pid);
+    TranspositionTable::Entry entry;
+    if (tt_.probe(key, entry) && entry.depth_ == depth - 1) {
+        ret = entry.score_;
+    } else {
+        const auto opMoves = legalMoves(board, 1 - pid);
+        ++counters_.local().legalMovesCalls_;
+        if (!opMoves.empty()) {
+            const auto best = bestMoveN(1 - pid, depth - 1, board, opMoves);
+            ret = best.second;
+            tt_.store(key, { best.second, depth - 1, TranspositionTable::EXACT, best.first });
+        }
+    }
+
+    board.undo(undo);
+    return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// The chance node is the board right after the move, before its card is drawn
+// (which is the board that plain minimax searches). Its replacement cards are
+// sampled with a PRNG seeded by its hash, so every visit to it draws the same
+// sample, and its score can be cached like any other board's.
+score_t
+MinimaxPlayer::chanceScore(player_id_t pid, unsigned depth, Board& board, const GameMove& move) const
+{
+    const auto undo = board.apply(pid, move);
+    if (pid == 0) {
+        board.newRound();
+    }
+    const auto key = board.hash(1 - pid);
+    board.undo(undo);
+
+    TranspositionTable::Entry entry;
+    if (chanceTT_.probe(key, entry) && entry.depth_ == depth - 1) {
+        return entry.score_;
+    }
+
+    const auto drawn = sampleUndealt(board, move.card().id_.type_, chanceSamples_, key);
+    assert(!drawn.empty());
+    score_t sum = 0;
+    for (const auto& card : drawn) {
+        sum += move.card().isWild()
+             ? replyScore(pid, depth, board, GameMove(card, RESERVE_CARD), NULL_CARD)
+             : replyScore(pid, depth, board, move, card);
+    }
+
+    const auto ret = sum / drawn.size();
+    chanceTT_.store(key, { ret, depth - 1, TranspositionTable::EXACT, TranspositionTable::NO_MOVE });
+    return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Return the indices of scores, sorted from highest to lowest score (ties keep
+// their original order). Comparing indices on ties gives the same order as a
+// stable sort, without its temporary buffer.
+using MoveOrder = StaticVector<unsigned, MAX_LEGAL_MOVES>;
+
+static MoveOrder
+orderByScore(const Scores& scores)
+{
+    MoveOrder order;
+    for (unsigned i = 0; i < scores.size(); ++i) {
+        order.push_back(i);
+    }
+    sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+        return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+    });
+    return order;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+AlphaBetaPlayer::AlphaBetaPlayer(unsigned maxDepth, const evaluator_t& eval, player_id_t pid,
+                                 score_t agingWeight, unsigned ttSizeLog2, unsigned moveMillis)
+        : Player(pid), depth_(maxDepth), evaluator_(eval), agingWeight_(agingWeight),
+          moveMillis_(moveMillis), depthReached_(0), tt_(ttSizeLog2)
+{
+    assert(maxDepth > 0 && "Minimum depth is one turn");
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// The state shared by all the tasks of one search. Once its deadline passes, the
+// search is abandoned cooperatively: the first task to notice cancels the task
+// group, so TBB starts no more of its tasks, and the running ones unwind.
+struct AlphaBetaPlayer::Search {
+    explicit Search(unsigned millis)
+      : timed_(millis > 0), deadline_(chrono::steady_clock::now() + chrono::milliseconds(millis))
+    {}
 
-static const auto allEval =
-        combine({ winCondition, countPoints, countPrestige, countGems, countMoves,
-                  monopolizeGems, preferWildcards, countReturns, preferShortGame, preferBuyTowardNoble },
-                { 100, 2, 1, 1, 0, 0, 0, -1, 1, 2 });
+    // Has the search been cancelled? (Cheap enough to call at every node.)
+    bool stopped() { return tasks_.is_group_execution_cancelled(); }
 
-static const auto allEval2 =
-        combine({ winCondition, countPoints, countPrestige, countGems, countMoves,
-                  monopolizeGems, preferWildcards, countReturns, preferShortGame, preferBuyTowardNoble },
-                { 100, 1.5, 1, 1, 2.25, -0.25, 0, -1, 1, 2.5 });
+    // Same, but also cancel the search if its time is up:
+    bool expired()
+    {
+        if (!stopped() && timed_ && chrono::steady_clock::now() >= deadline_) {
+            tasks_.cancel_group_execution();
+        }
+        return stopped();
+    }
+
+    const bool timed_;
+    const chrono::steady_clock::time_point deadline_;
+    tbb::task_group_context tasks_;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// With no time budget, search to the maximum depth. Otherwise, search to depth 1,
+// 2, 3... until the time runs out (or the maximum depth is reached), each time
+// starting with the previous best move, and return the deepest completed result.
+GameMove
+AlphaBetaPlayer::getMove(const Board& board, const Moves& legal, GameContext& context) const
+{
+    assert(board.playersNum() == 2 && "Alpha-beta only defined for two players");
+    const MoveMeter meter(counters_, context);
+    const auto millis = context.moveMillis_? context.moveMillis_ : moveMillis_;
+    if (!millis) {
+        Search search(0);
+        depthReached_ = depth_;
+        const auto bestIdx = searchRoot(depth_, board, legal, TranspositionTable::NO_MOVE, search);
+        moveStats_ = meter.stats(depthReached_);
+        return legal.at(bestIdx);
+    }
+
+    Search search(millis);
+    unsigned bestIdx = searchRoot(1, board, legal, TranspositionTable::NO_MOVE, search);
+    depthReached_ = 1;
+    for (unsigned depth = 2; depth <= depth_ && !search.expired(); ++depth) {
+        const auto idx = searchRoot(depth, board, legal, bestIdx, search);
+        if (search.stopped()) {
+            break;
+        }
+        bestIdx = idx;
+        depthReached_ = depth;
+    }
+    moveStats_ = meter.stats(depthReached_);
+    return legal.at(bestIdx);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// The root is searched like any other node, except that it has to return the
+// same move as MinimaxPlayer, which picks the first of several equal-scoring moves.
+// So a move that precedes the current best one is searched with a window that's
+// slightly lower than the best score, where a tie still yields an exact score.
+// The first move (the previous best, if any) is searched alone, to set a bound
+// for the others, which are then searched in parallel. Every move is searched in
+// a task of search.tasks_, even the first one, since the task contexts of the
+// nodes below bind to the context of the task that runs them: that's how they
+// are cancelled along with the search. Returns the index of the best move, which
+// is meaningless if the search was cancelled meanwhile.
+unsigned
+AlphaBetaPlayer::searchRoot(unsigned depth, const Board& board, const Moves& legal,
+                            unsigned prevBest, Search& search) const
+{
+    static constexpr auto inf = numeric_limits<score_t>::infinity();
+    const auto pid = Player::pid_;
+
+    const auto scores = depth * agingWeight_ * scoreMoves(evaluator_, legal, pid, board, counters_);
+    auto order = orderByScore(scores);
+    if (prevBest < order.size()) {
+        const auto where = find(order.begin(), order.end(), prevBest);
+        rotate(order.begin(), where, where + 1);
+    }
+
+    mutex bestMutex;  // Guards bestIdx and bestScore
+    unsigned bestIdx = order.front();
+    auto bestScore = -inf;
+
+    const auto searchMove = [&](unsigned idx, Board& work) {
+        auto score = scores[idx];
+        if (depth > 1) {
+            const auto undo = work.apply(pid, legal[idx]);
+            if (pid == 0) {
+                work.newRound();
+            }
+            const auto opMoves = legalMoves(work, 1 - pid);
+            ++counters_.local().legalMovesCalls_;
+            if (!opMoves.empty()) {
+                unique_lock<mutex> lock(bestMutex);
+                const auto tieMargin = 1e-9 * (1 + std::abs(bestScore));
+                const auto alpha = (idx < bestIdx)? bestScore - tieMargin : bestScore;
+                lock.unlock();
+                score -= negamax(1 - pid, depth - 1, work, opMoves,
+                                 scores[idx] - inf, scores[idx] - alpha, search, search.tasks_);
+            }
+            work.undo(undo);
+        }
+
+        lock_guard<mutex> lock(bestMutex);
+        if (score > bestScore || (score == bestScore && idx < bestIdx)) {
+            bestScore = score;
+            bestIdx = idx;
+        }
+    };
+
+    tbb::parallel_for(tbb::blocked_range<unsigned>(0, 1), [&](const tbb::blocked_range<unsigned>&) {
+        Board work = board;
+        ++counters_.local().boardCopies_;
+        searchMove(order.front(), work);
+    }, search.tasks_);
+    tbb::parallel_for(tbb::blocked_range<unsigned>(1, order.size()),
+                      [&](const tbb::blocked_range<unsigned>& range)
+    {
+        Board work = board;  // Each task walks its own copy of the board
+        auto& counts = counters_.local();
+        ++counts.tasks_;
+        ++counts.boardCopies_;
+        for (auto i = range.begin(); i != range.end() && !search.stopped(); ++i) {
+            searchMove(order[i], work);
+        }
+    }, search.tasks_);
+
+    return bestIdx;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Returns the same score as MinimaxPlayer::bestMoveN if it falls within (alpha, beta),
+// or a bound on it otherwise (fail-soft): a score <= alpha means the real score is
+// no higher, and a score >= beta means the real score is no lower.
+// Each move contributes its own (aged) score, minus the opponent's best reply, so
+// a child's window is shifted by the move's score and negated.
+// The search is parallel, by "Young Brothers Wait": at least MIN_SPLIT_DEPTH turns
+// from the leaves, the first (eldest) move is searched alone, and if it doesn't
+// cut off the search, its siblings are then searched in parallel tasks. These share
+// the best score so far, so each starts with the narrowest window known, and the
+// first to reach beta cancels the rest (whose scores are then ignored). A smaller
+// alpha than a serial search would have only means less pruning, not a different
+// score, so the result is the same, no matter how the tasks interleave.
+// The board is modified during the search, but restored before returning.
+score_t
+AlphaBetaPlayer::negamax(player_id_t pid,          // The player making the current move
+                         unsigned depth,           // Depth of recursion (how many more turns)
+                         Board& board,             // Current board state
+                         const Moves& legal,       // List of current legal movees
+                         score_t alpha,            // Score we're already guaranteed elsewhere
+                         score_t beta,             // Score the opponent won't let us exceed
+                         Search& search,           // Where to check for a timeout
+                         tbb::task_group_context& group) const  // The tasks this search belongs to
+{
+    assert(!legal.empty());
+    if (search.expired() || group.is_group_execution_cancelled()) {
+        return 0;  // Will be ignored anyway
+    }
+
+    // A previous search of this board may have already settled its score. Or
+    // a shallower one may at least tell us which move to try first:
+    const auto key = board.hash(pid);
+    TranspositionTable::Entry entry;
+    auto ttMove = TranspositionTable::NO_MOVE;
+    if (tt_.probe(key, entry)) {
+        if (entry.depth_ == depth
+            && (entry.bound_ == TranspositionTable::EXACT
+             || (entry.bound_ == TranspositionTable::LOWER && entry.score_ >= beta)
+             || (entry.bound_ == TranspositionTable::UPPER && entry.score_ <= alpha))) {
+            return entry.score_;
+        }
+        ttMove = entry.bestMove_;
+    }
+
+    const auto scores = depth * agingWeight_ * scoreMoves(evaluator_, legal, pid, board, counters_);
+    if (depth == 1) {
+        const auto best = max_element(scores.cbegin(), scores.cend());
+        tt_.store(key, { *best, depth, TranspositionTable::EXACT,
+                         unsigned(distance(scores.cbegin(), best)) });
+        return *best;
+    }
+
+    // Try the best move of the previous search first, then by score:
+    auto order = orderByScore(scores);
+    if (ttMove < order.size()) {
+        const auto where = find(order.begin(), order.end(), ttMove);
+        rotate(order.begin(), where, where + 1);
+    }
+
+    // The score of the move at position pos of the order, searched on work:
+    const auto searchMove = [&](unsigned pos, Board& work, score_t alpha, tbb::task_group_context& group) {
+        const auto idx = order[pos];
+        auto score = scores[idx];
+        const auto undo = work.apply(pid, legal[idx]);
+        if (pid == 0) {
+            work.newRound();
+        }
+
+        const auto opMoves = legalMoves(work, 1 - pid);
+        ++counters_.local().legalMovesCalls_;
+        if (!opMoves.empty()) {
+            score -= negamax(1 - pid, depth - 1, work, opMoves,
+                             scores[idx] - beta, scores[idx] - alpha, search, group);
+        }
+        work.undo(undo);
+        return score;
+    };
+
+    const auto origAlpha = alpha;
+    auto best = -numeric_limits<score_t>::infinity();
+    unsigned bestPos = 0;
+    const bool split = depth >= MIN_SPLIT_DEPTH && tbb::this_task_arena::max_concurrency() > 1;
+    const unsigned serial = split? 1 : order.size();
+    for (unsigned pos = 0; pos < serial; ++pos) {
+        const auto score = searchMove(pos, board, alpha, group);
+        if (group.is_group_execution_cancelled()) {
+            return best;  // The score may be incomplete (and ours will be ignored)
+        }
+        if (score > best) {
+            best = score;
+            bestPos = pos;
+        }
+        alpha = max(alpha, best);
+        if (alpha >= beta) {
+            break;
+        }
+    }
+
+    if (serial < order.size() && alpha < beta && !group.is_group_execution_cancelled()) {
+        mutex bestMutex;                   // Guards best, bestPos, and alpha
+        // Bound to the context of the task running this node (which is group, or
+        // bound to it), so cancelling group cancels the siblings too:
+        tbb::task_group_context siblings;
+        tbb::parallel_for(tbb::blocked_range<unsigned>(serial, order.size()),
+                          [&](const tbb::blocked_range<unsigned>& range)
+        {
+            Board work = board;  // Each task walks its own copy of the board
+            auto& counts = counters_.local();
+            ++counts.tasks_;
+            ++counts.boardCopies_;
+            for (auto pos = range.begin(); pos != range.end(); ++pos) {
+                unique_lock<mutex> lock(bestMutex);
+                if (siblings.is_group_execution_cancelled()) {
+                    break;  // The siblings reached beta, or the whole search stopped
+                }
+                const auto curAlpha = alpha;
+                lock.unlock();
+
+                const auto score = searchMove(pos, work, curAlpha, siblings);
+                lock.lock();
+                if (siblings.is_group_execution_cancelled()) {
+                    break;  // The score may be incomplete
+                }
+                if (score > best || (score == best && pos < bestPos)) {
+                    best = score;
+                    bestPos = pos;
+                }
+                alpha = max(alpha, best);
+                if (alpha >= beta) {
+                    siblings.cancel_group_execution();
+                }
+            }
+        }, siblings);
+    }
+
+    if (search.stopped() || group.is_group_execution_cancelled()) {
+        return best;  // An incomplete result mustn't be stored
+    }
+    const auto bound = (best <= origAlpha)? TranspositionTable::UPPER
+                     : (best >= beta)?      TranspositionTable::LOWER
+                     :                      TranspositionTable::EXACT;
+    tt_.store(key, { best, depth, bound, order[bestPos] });
+    return best;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+NegamaxPlayer::NegamaxPlayer(unsigned maxDepth, const position_evaluator_t& eval, player_id_t pid,
+                             unsigned ttSizeLog2, unsigned quiescencePlies)
+        : Player(pid), depth_(maxDepth), quiescence_(quiescencePlies), evaluator_(eval), tt_(ttSizeLog2)
+{
+    assert(maxDepth > 0 && "Minimum depth is one turn");
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// The root is searched like any other node, except that it returns the best move.
+GameMove
+NegamaxPlayer::getMove(const Board& board, const Moves& legal, GameContext& context) const
+{
+    assert(board.playersNum() == 2 && "Negamax only defined for two players");
+    static constexpr auto inf = numeric_limits<score_t>::infinity();
+    const MoveMeter meter(counters_, context);
+    const auto pid = Player::pid_;
+    auto& counts = counters_.local();
+    ++counts.nodes_;
+    counts.movesScored_ += legal.size();
+
+    Board work = board;
+    ++counts.boardCopies_;
+    auto best = -inf;
+    unsigned bestIdx = 0;
+    for (const auto idx : orderMoves(pid, depth_, work, legal, TranspositionTable::NO_MOVE)) {
+        const auto undo = work.apply(pid, legal[idx]);
+        if (pid == 0) {
+            work.newRound();
+        }
+        const auto score = -negamax(1 - pid, depth_ - 1, work, -inf, -best);
+        work.undo(undo);
+
+        if (score > best) {
+            best = score;
+            bestIdx = idx;
+        }
+    }
+    moveStats_ = meter.stats(depth_);
+    return legal.at(bestIdx);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+score_t
+NegamaxPlayer::leafValue(player_id_t pid, const Board& board) const
+{
+    if (!counters_.timed_) {
+        return evaluator_(board, pid) - evaluator_(board, 1 - pid);
+    }
+
+    const auto start = chrono::steady_clock::now();
+    const auto ret = evaluator_(board, pid) - evaluator_(board, 1 - pid);
+    counters_.local().evalNanos_ +=
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Sorting the moves by the values of their boards pays off only where these
+// boards aren't the leaves anyway, so at depth 1 the moves keep their order.
+NegamaxPlayer::MoveOrder
+NegamaxPlayer::orderMoves(player_id_t pid, unsigned depth, Board& board, const Moves& legal,
+                          unsigned first) const
+{
+    MoveOrder order;
+    if (depth > 1) {
+        Scores values;
+        for (const auto& mv : legal) {
+            const auto undo = board.apply(pid, mv);
+            if (pid == 0) {
+                board.newRound();
+            }
+            values.push_back(-leafValue(1 - pid, board));
+            board.undo(undo);
+        }
+        order = orderByScore(values);
+    } else {
+        for (unsigned i = 0; i < legal.size(); ++i) {
+            order.push_back(i);
+        }
+    }
+
+    if (first < order.size()) {
+        const auto where = find(order.begin(), order.end(), first);
+        rotate(order.begin(), where, where + 1);
+    }
+    return order;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Returns the value of the board for pid if it falls within (alpha, beta), or a
+// bound on it otherwise (fail-soft). Like in the game loop, the game can only end
+// with a round, i.e., when it's player 0's turn, so a board where the game is
+// over then is a leaf at any depth. A player without moves passes the turn.
+// The board is modified during the search, but restored before returning.
+score_t
+NegamaxPlayer::negamax(player_id_t pid,       // The player making the current move
+                       unsigned depth,        // Depth of recursion (how many more turns)
+                       Board& board,          // Current board state
+                       score_t alpha,         // Value we're already guaranteed elsewhere
+                       score_t beta) const    // Value the opponent won't let us exceed
+{
+    if (depth == 0) {
+        return quiesce(pid, quiescence_, board, alpha, beta);
+    }
+    auto& counts = counters_.local();
+    ++counts.nodes_;
+    if (pid == 0 && board.gameOver()) {
+        return leafValue(pid, board);
+    }
+
+    // A search of this board to the same depth or deeper may have settled its value:
+    const auto key = board.hash(pid);
+    TranspositionTable::Entry entry;
+    auto ttMove = TranspositionTable::NO_MOVE;
+    if (tt_.probe(key, entry)) {
+        if (entry.depth_ >= depth
+            && (entry.bound_ == TranspositionTable::EXACT
+             || (entry.bound_ == TranspositionTable::LOWER && entry.score_ >= beta)
+             || (entry.bound_ == TranspositionTable::UPPER && entry.score_ <= alpha))) {
+            return entry.score_;
+        }
+        ttMove = entry.bestMove_;
+    }
+
+    Moves legal;
+    legalMoves(board, pid, legal);
+    ++counts.legalMovesCalls_;
+    counts.movesScored_ += legal.size();
+    if (legal.empty()) {
+        Board next = board;
+        ++counts.boardCopies_;
+        if (pid == 0) {
+            next.newRound();
+        }
+        return -negamax(1 - pid, depth - 1, next, -beta, -alpha);
+    }
+
+    const auto origAlpha = alpha;
+    auto best = -numeric_limits<score_t>::infinity();
+    unsigned bestIdx = 0;
+    for (const auto idx : orderMoves(pid, depth, board, legal, ttMove)) {
+        const auto undo = board.apply(pid, legal[idx]);
+        if (pid == 0) {
+            board.newRound();
+        }
+        const auto score = -negamax(1 - pid, depth - 1, board, -beta, -alpha);
+        board.undo(undo);
+
+        if (score > best) {
+            best = score;
+            bestIdx = idx;
+        }
+        alpha = max(alpha, best);
+        if (alpha >= beta) {
+            break;
+        }
+    }
+
+    const auto bound = (best <= origAlpha)? TranspositionTable::UPPER
+                     : (best >= beta)?      TranspositionTable::LOWER
+                     :                      TranspositionTable::EXACT;
+    tt_.store(key, { best, depth, bound, bestIdx });
+    return best;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// The moves that quiescence search keeps searching: every buy, since even one
+// without points adds prestige for good, which brings nobles and other cards
+// closer, and reserving a table card that the opponent could buy for points
+// on their next turn (the threats of which are in opponentCanBuy).
+static bool
+isTactical(const GameMove& move, const CardMask& opponentCanBuy)
+{
+    if (move.type() == BUY_CARD) {
+        return true;
+    }
+    if (move.type() != RESERVE_CARD || move.card().isWild()) {
+        return false;
+    }
+    const auto idx = cardIndex(move.card());
+    return opponentCanBuy[idx] && g_card_table.points_[idx] > 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Like negamax, but pid may also "stand pat" on the board's static value, since
+// it's assumed that some quiet move would keep it. So only the tactical moves
+// can raise it. Quiescence values aren't stored in the transposition table, as
+// they don't come from a full-width search.
+score_t
+NegamaxPlayer::quiesce(player_id_t pid, unsigned plies, Board& board, score_t alpha, score_t beta) const
+{
+    auto& counts = counters_.local();
+    ++counts.nodes_;
+    auto best = leafValue(pid, board);
+    if (plies == 0 || (pid == 0 && board.gameOver()) || best >= beta) {
+        return best;
+    }
+    alpha = max(alpha, best);
+
+    Moves legal;
+    legalMoves(board, pid, legal);
+    ++counts.legalMovesCalls_;
+    counts.movesScored_ += legal.size();
+    const auto opponentCanBuy = board.affordableCards(1 - pid);
+    for (const auto& mv : legal) {
+        if (!isTactical(mv, opponentCanBuy)) {
+            continue;
+        }
+        const auto undo = board.apply(pid, mv);
+        if (pid == 0) {
+            board.newRound();
+        }
+        best = max(best, -quiesce(1 - pid, plies - 1, board, -beta, -alpha));
+        board.undo(undo);
+
+        alpha = max(alpha, best);
+        if (alpha >= beta) {
+            break;
+        }
+    }
+    return best;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// The evaluators are fused at compile time, with their terms in Feature order:
+static const evaluator_t comboEval =
+        FusedEvaluator<Term<WINS, 100>, Term<POINT_GAIN, 2>, Term<PRESTIGE_GAIN, 1>>();
+
+static const evaluator_t allEval =
+        FusedEvaluator<Term<WINS, 100>, Term<POINT_GAIN, 2>, Term<PRESTIGE_GAIN, 1>, Term<GEM_GAIN, 1>,
+                       Term<RETURNS, -1>, Term<GAME_LENGTH, 1>, Term<NOBLE_PROGRESS, 2>>();
+
+static const evaluator_t allEval2 =
+        FusedEvaluator<Term<WINS, 100>, Term<POINT_GAIN, 3, 2>, Term<PRESTIGE_GAIN, 1>, Term<GEM_GAIN, 1>,
+                       Term<MOBILITY, 9, 4>, Term<RARITY, -1, 4>, Term<RETURNS, -1>, Term<GAME_LENGTH, 1>,
+                       Term<NOBLE_PROGRESS, 5, 2>>();
 
 
 static PlayerFactory::Registrator regs1("minimax-1",
@@ -105,4 +772,77 @@ static PlayerFactory::Registrator regs6("minimax-6",
 
 static PlayerFactory::Registrator regs7("minimax-7",
                                         [](player_id_t pid){ return new MinimaxPlayer(7, allEval, pid, 0.01); });
+
+// Minimax with chance nodes, that averages over a few drawn replacement cards:
+static constexpr unsigned CHANCE_SAMPLES = 3;
+
+static PlayerFactory::Registrator rege2("expectimax-2",
+        [](player_id_t pid){ return new MinimaxPlayer(2, allEval, pid, 0.01, DEFAULT_TT_SIZE_LOG2, CHANCE_SAMPLES); });
+
+static PlayerFactory::Registrator rege3("expectimax-3",
+        [](player_id_t pid){ return new MinimaxPlayer(3, allEval, pid, 0.01, DEFAULT_TT_SIZE_LOG2, CHANCE_SAMPLES); });
+
+static PlayerFactory::Registrator rege4("expectimax-4",
+        [](player_id_t pid){ return new MinimaxPlayer(4, allEval, pid, 0.01, DEFAULT_TT_SIZE_LOG2, CHANCE_SAMPLES); });
+
+static PlayerFactory::Registrator rega1("alphabeta-1",
+                                        [](player_id_t pid){ return new AlphaBetaPlayer(1, allEval, pid, 0.01); });
+
+static PlayerFactory::Registrator rega2("alphabeta-2",
+                                        [](player_id_t pid){ return new AlphaBetaPlayer(2, allEval, pid, 0.01); });
+
+static PlayerFactory::Registrator rega3("alphabeta-3",
+                                        [](player_id_t pid){ return new AlphaBetaPlayer(3, allEval, pid, 0.01); });
+
+static PlayerFactory::Registrator rega4("alphabeta-4",
+                                        [](player_id_t pid){ return new AlphaBetaPlayer(4, allEval, pid, 0.01); });
+
+static PlayerFactory::Registrator rega5("alphabeta-5",
+                                        [](player_id_t pid){ return new AlphaBetaPlayer(5, allEval, pid, 0.01); });
+
+static PlayerFactory::Registrator rega6("alphabeta-6",
+                                        [](player_id_t pid){ return new AlphaBetaPlayer(6, allEval, pid, 0.01); });
+
+static PlayerFactory::Registrator rega7("alphabeta-7",
+                                        [](player_id_t pid){ return new AlphaBetaPlayer(7, allEval, pid, 0.01); });
+
+// Search as deep as a second per move allows (or --move-ms), up to 32 turns:
+static PlayerFactory::Registrator regd("deepening",
+        [](player_id_t pid){ return new AlphaBetaPlayer(32, allEval, pid, 0.01, DEFAULT_TT_SIZE_LOG2, 1000); });
+
+// Scoring only the leaves is cheaper per node, so these levels start deeper.
+// (Terms that are the same for both players cancel out, so they're left out.)
+static const auto positionEval =
+        combinePositions({ positionWin, positionPoints, positionPrestige, positionGems, positionNobleProgress },
+                         { 100,         2,              1,                1,            2 });
+
+static PlayerFactory::Registrator regn2("negamax-2",
+        [](player_id_t pid){ return new NegamaxPlayer(2, positionEval, pid); });
+
+static PlayerFactory::Registrator regn3("negamax-3",
+        [](player_id_t pid){ return new NegamaxPlayer(3, positionEval, pid); });
+
+static PlayerFactory::Registrator regn4("negamax-4",
+        [](player_id_t pid){ return new NegamaxPlayer(4, positionEval, pid); });
+
+static PlayerFactory::Registrator regn5("negamax-5",
+        [](player_id_t pid){ return new NegamaxPlayer(5, positionEval, pid); });
+
+static PlayerFactory::Registrator regn6("negamax-6",
+        [](player_id_t pid){ return new NegamaxPlayer(6, positionEval, pid); });
+
+static PlayerFactory::Registrator regn7("negamax-7",
+        [](player_id_t pid){ return new NegamaxPlayer(7, positionEval, pid); });
+
+static PlayerFactory::Registrator regn8("negamax-8",
+        [](player_id_t pid){ return new NegamaxPlayer(8, positionEval, pid); });
+
+// The same, but with up to 4 more turns of tactical moves past the depth:
+static constexpr unsigned QUIESCENCE_PLIES = 4;
+
+static PlayerFactory::Registrator regq3("negamax-quiet-3",
+        [](player_id_t pid){ return new NegamaxPlayer(3, positionEval, pid, DEFAULT_TT_SIZE_LOG2, QUIESCENCE_PLIES); });
+
+static PlayerFactory::Registrator regq5("negamax-quiet-5",
+        [](player_id_t pid){ return new NegamaxPlayer(5, positionEval, pid, DEFAULT_TT_SIZE_LOG2, QUIESCENCE_PLIES); });
 } // namespace
@@ -12,23 +12,158 @@
 
 #include "player.h"
 #include "eval.h"
+#include "search_stats.h"
+#include "transposition_table.h"
+
+#include <tbb/task_group.h>
+
+#include <atomic>
+#include <cstdint>
 
 namespace grandeur {
 
+// Default size of the players' transposition tables (2^18 entries, 6MB):
+static constexpr unsigned DEFAULT_TT_SIZE_LOG2 = 18;
+
+// Given a no. of chance samples, it's an expectimax player instead: a move that
+// draws a card from a deck (buying or reserving a table card, which gets replaced,
+// or reserving from a deck) leads to a chance node, whose score is the mean of the
+// scores of up to that many replacement cards, drawn from those that could still
+// be undealt. Otherwise, such cards just disappear from the searched boards.
 class MinimaxPlayer final : public Player {
   public:
-    MinimaxPlayer(unsigned maxDepth, const evaluator_t& eval, player_id_t pid, score_t agingWeight = 1);
+    MinimaxPlayer(unsigned maxDepth, const evaluator_t& eval, player_id_t pid, score_t agingWeight = 1,
+                  unsigned ttSizeLog2 = DEFAULT_TT_SIZE_LOG2, unsigned chanceSamples = 0);
 
     virtual GameMove
-    getMove(const Board& board, const Moves& legal) const;
+    getMove(const Board& board, const Moves& legal, GameContext& context) const;
+
+    // Total no. of search nodes (boards whose moves got scored) visited so far:
+    uint64_t nodesVisited() const { return counters_.read().nodes_; }
+
+    virtual const SearchStats* moveStats() const { return &moveStats_; }
+
+    const TranspositionTable& transpositions() const { return tt_; }
 
   private:
     std::pair<unsigned, score_t>
-    bestMoveN(player_id_t pid, unsigned depth, const Board& board, const Moves& legal) const;
+    bestMoveN(player_id_t pid, unsigned depth, Board& board, const Moves& legal) const;
+
+    // The opponent's best score after a move, with a given card drawn for it:
+    score_t replyScore(player_id_t pid, unsigned depth, Board& board, const GameMove& move,
+                       const Card& replacement) const;
+
+    // The mean of replyScore over a sample of the cards a move could draw:
+    score_t chanceScore(player_id_t pid, unsigned depth, Board& board, const GameMove& move) const;
 
     unsigned depth_;
     evaluator_t evaluator_;
     score_t agingWeight_;
+    unsigned chanceSamples_;             // Replacement cards per chance node (or none)
+    mutable SearchCounters counters_;
+    mutable SearchStats moveStats_;      // Of the last move
+    mutable TranspositionTable tt_;      // Exact scores of searched boards, by depth
+    mutable TranspositionTable chanceTT_;  // Scores of chance nodes, by depth
+};
+
+
+// A Mini-Max player with alpha-beta pruning, in negamax form. It scores moves
+// exactly like MinimaxPlayer, so at the same depth it picks the same move. But it
+// searches the moves in order of their one-ply score, and skips any subtree that
+// can no longer change the result.
+// Given a time budget per move (in the constructor, or overridden by the game
+// context), it deepens its search iteratively instead, up to the maximum depth,
+// and plays the best move of the deepest search that completed in time.
+class AlphaBetaPlayer final : public Player {
+  public:
+    AlphaBetaPlayer(unsigned maxDepth, const evaluator_t& eval, player_id_t pid, score_t agingWeight = 1,
+                    unsigned ttSizeLog2 = DEFAULT_TT_SIZE_LOG2, unsigned moveMillis = 0);
+
+    virtual GameMove
+    getMove(const Board& board, const Moves& legal, GameContext& context) const;
+
+    // Total no. of search nodes (boards whose moves got scored) visited so far:
+    uint64_t nodesVisited() const { return counters_.read().nodes_; }
+
+    // The depth of the search that produced the last move:
+    unsigned depthReached() const { return depthReached_; }
+
+    virtual const SearchStats* moveStats() const { return &moveStats_; }
+
+    const TranspositionTable& transpositions() const { return tt_; }
+
+  private:
+    struct Search;
+
+    unsigned searchRoot(unsigned depth, const Board& board, const Moves& legal,
+                        unsigned prevBest, Search& search) const;
+
+    score_t negamax(player_id_t pid, unsigned depth, Board& board, const Moves& legal,
+                    score_t alpha, score_t beta, Search& search, tbb::task_group_context& group) const;
+
+    // Search the siblings of a node's first move in parallel only this many turns
+    // from the leaves, where a subtree is worth a task:
+    static constexpr unsigned MIN_SPLIT_DEPTH = 3;
+
+    unsigned depth_;
+    evaluator_t evaluator_;
+    score_t agingWeight_;
+    unsigned moveMillis_;  // Time budget per move (zero for a fixed depth)
+    mutable SearchCounters counters_;
+    mutable SearchStats moveStats_;  // Of the last move
+    mutable unsigned depthReached_;
+    mutable TranspositionTable tt_;  // Scores or score bounds of searched boards, by depth
+};
+
+
+// A Mini-Max player that only scores the boards at the leaves of its search, with
+// a position evaluator, in negamax form with alpha-beta pruning. A leaf is worth
+// its score for the player to move there, minus the opponent's score. Since the
+// value of a board doesn't depend on the moves that led to it, the transposition
+// table stores board values, which any later search at the same depth or less
+// can reuse. Moves are searched in order of the (static) value of the boards
+// they lead to, after the best move of any previous search of the board.
+// Past its maximum depth, it can keep searching the tactical moves (all buys,
+// including the game-winning ones and those that win or approach a noble, and
+// reserving a card the opponent could buy for points next), up to
+// quiescencePlies more turns, so that it doesn't stop right before one.
+// In its search statistics, every board visited is a node, whose moves count as
+// scored, and the time to score moves is the time spent evaluating positions.
+class NegamaxPlayer final : public Player {
+  public:
+    NegamaxPlayer(unsigned maxDepth, const position_evaluator_t& eval, player_id_t pid,
+                  unsigned ttSizeLog2 = DEFAULT_TT_SIZE_LOG2, unsigned quiescencePlies = 0);
+
+    virtual GameMove
+    getMove(const Board& board, const Moves& legal, GameContext& context) const;
+
+    // Total no. of search nodes (boards visited, leaves included) so far:
+    uint64_t nodesVisited() const { return counters_.read().nodes_; }
+
+    virtual const SearchStats* moveStats() const { return &moveStats_; }
+
+    const TranspositionTable& transpositions() const { return tt_; }
+
+  private:
+    // The static value of a board for the player to move:
+    score_t leafValue(player_id_t pid, const Board& board) const;
+
+    // The indices of the legal moves, in the order to search them:
+    using MoveOrder = StaticVector<unsigned, MAX_LEGAL_MOVES>;
+    MoveOrder orderMoves(player_id_t pid, unsigned depth, Board& board, const Moves& legal,
+                         unsigned first) const;
+
+    score_t negamax(player_id_t pid, unsigned depth, Board& board, score_t alpha, score_t beta) const;
+
+    // Search only the tactical moves, up to plies more turns:
+    score_t quiesce(player_id_t pid, unsigned plies, Board& board, score_t alpha, score_t beta) const;
+
+    unsigned depth_;
+    unsigned quiescence_;  // Max. no. of turns to search tactical moves past depth_
+    position_evaluator_t evaluator_;
+    mutable SearchCounters counters_;
+    mutable SearchStats moveStats_;  // Of the last move
+    mutable TranspositionTable tt_;  // Values or value bounds of searched boards, by depth
 };
 
 }  // namespace
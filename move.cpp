@@ -10,42 +10,29 @@
 #include "board.h"
 #include "player.h"
 #include "move_notifier.h"
+#include "take_gems.h"
 
 using namespace std;
 
 namespace grandeur {
 
-///////////////////////////////////////////////////////////////////
-bool GameMove::operator==(const GameMove& rhs) const
-{
-    if (type_ != rhs.type_) {
-        return false;
-    }
-    if (type_ == MoveType::TAKE_GEMS) {
-        return payload_.gems_ == rhs.payload_.gems_;
-    } else {
-        return payload_.card_ == rhs.payload_.card_;
-    }
-}
-
-
 ///////////////////////////////////////////////////////////////////
 ostream& operator<<(ostream& os, const GameMove& mv)
 {
     static constexpr const char* dname[] = { "LOW", "MEDIUM", "HIGH" };
-    switch (mv.type_) {
+    switch (mv.type()) {
     case TAKE_GEMS:
-        os << "Take: " << mv.payload_.gems_;
+        os << "Take: " << mv.gems();
         break;
     case BUY_CARD:
-        os << "Buy: " << mv.payload_.card_.id_;
+        os << "Buy: " << mv.card().id_;
         break;
     case RESERVE_CARD:
         os << "Reserve: ";
-        if (mv.payload_.card_.isWild()) {
-            os << "Wildcard from deck " << dname[mv.payload_.card_.id_.type_];
+        if (mv.card().isWild()) {
+            os << "Wildcard from deck " << dname[mv.card().id_.type_];
         } else {
-            os << mv.payload_.card_.id_;
+            os << mv.card().id_;
         }
         break;
     }
@@ -53,124 +40,73 @@ ostream& operator<<(ostream& os, const GameMove& mv)
     return os;
 }
 
-using Counts = array<gem_count_t, 5>;
-
 ///////////////////////////////////////////////////////////////////
-// Test whether a combination of gems we're trying to take are too many gems for
-// the given table gems
-bool inline
-isLegalTake(const Counts& take, const Counts& table, const Counts& mine)
+constexpr GemDigits::GemDigits()
+  : low_{}, high_{}
 {
-    for (unsigned i = 0; i < NCOLOR - 1; ++i) {
-        if ((take[i] > table[i])
-        ||  (mine[i] + take[i] < 0)
-        ||  (take[i] == SAME_COLOR_GEMS && table[i] < MIN_SAME_COLOR_TABLE_GEMS)) {
-            return false;
-        }
+    static_assert(SIZE == GameMove::GEM_BASE * GameMove::GEM_BASE * GameMove::GEM_BASE,
+                  "Three digits per table");
+    for (unsigned i = 0; i < SIZE; ++i) {
+        const int d0 = int(i % GameMove::GEM_BASE) - GameMove::GEM_OFFSET;
+        const int d1 = int(i / GameMove::GEM_BASE % GameMove::GEM_BASE) - GameMove::GEM_OFFSET;
+        const int d2 = int(i / GameMove::GEM_BASE / GameMove::GEM_BASE) - GameMove::GEM_OFFSET;
+        low_[i] = Gems(d0, d1, d2);
+        high_[i] = Gems(0, 0, 0, d0, d1, d2);
     }
-
-    return true;
 }
 
+constexpr GemDigits g_gem_digits;
 
-///////////////////////////////////////////////////////////////////
-// For a given vector of gem-count combinations, search all permutation of this
-// combination to find legal gem-taking permutations, and add them to moves.
-// A gem-count combination is an ascending-sorted array of five counts, representing
-// How many gems of each colors to take (where the actual colors vary by permutation).
-static void
-addTakeGemCombination(Moves& moves, player_id_t pid, const Board& board,
-                      Counts counts, const Counts& table, const Counts& mine)
-{
-    do {
-        if (isLegalTake(counts, table, mine)) {
-            moves.push_back(GameMove(Gems(begin(counts), end(counts))));
-        }
-    } while (next_permutation(begin(counts), end(counts)));
+constexpr TakeTable g_take_table;
 
-}
+// Any row of take patterns, plus buying or reserving any table card or reserve
+// (or wildcard), must fit in a list of moves. With 10 gems, nothing can be reserved:
+static_assert(g_take_table.size(MAX_PLAYER_GEMS - 1)
+              + 2 * (NDECKS * INITIAL_DECK_NCARD + MAX_PLAYER_RESERVES) <= MAX_LEGAL_MOVES
+           && g_take_table.size(MAX_PLAYER_GEMS - 2)
+              + 2 * (NDECKS * INITIAL_DECK_NCARD + MAX_PLAYER_RESERVES) <= MAX_LEGAL_MOVES
+           && g_take_table.size(MAX_PLAYER_GEMS)
+              + NDECKS * INITIAL_DECK_NCARD + MAX_PLAYER_RESERVES <= MAX_LEGAL_MOVES,
+              "MAX_LEGAL_MOVES is too small");
 
 ///////////////////////////////////////////////////////////////////
-// Enumerate all possible combinations of taking gems that match the amount
-// of gems player already has.
+// Add all the legal ways to take gems from the table, from the patterns that
+// match the amount of gems the player already has.
 static void
 addTakeGemMoves(Moves& moves, player_id_t pid, const Board& board)
 {
-    static const Counts sameColor =   {  0,  0,  0,  0,  2 };
-    static const Counts diffColors =  {  0,  0,  1,  1,  1 };
-    static const Counts netAddZero1 = { -2,  0,  0,  0,  2 };
-    static const Counts netAddZero2 = { -1, -1,  0,  1,  1 };
-    static const Counts netAddOne1 =  { -1,  0,  0,  0,  2 };
-    static const Counts netAddOne2 =  { -1, -1,  1,  1,  1 };
-    static const Counts netAddTwo1 =  { -1,  0,  1,  1,  1 };
-    static const Counts netAddTwo2 =  {  0,  0,  0,  1,  1 };
-
-    const Counts table({ board.tableGems().getCount(gem_color_t(0)),
-                         board.tableGems().getCount(gem_color_t(1)),
-                         board.tableGems().getCount(gem_color_t(2)),
-                         board.tableGems().getCount(gem_color_t(3)),
-                         board.tableGems().getCount(gem_color_t(4))
-                       });
-    const Counts mine({ board.playerGems(pid).getCount(gem_color_t(0)),
-                        board.playerGems(pid).getCount(gem_color_t(1)),
-                        board.playerGems(pid).getCount(gem_color_t(2)),
-                        board.playerGems(pid).getCount(gem_color_t(3)),
-                        board.playerGems(pid).getCount(gem_color_t(4))
-                      });
-
-    const auto ngems = board.playerGems(pid).totalGems();
-
-    // Enumerate all legal moves that take gems of a single color:
-    if (ngems <= MAX_PLAYER_GEMS - SAME_COLOR_GEMS) {
-        addTakeGemCombination(moves, pid, board, sameColor, table, mine);
-    }
-
-    // Enumerate all legal moves that take gems of different colors (no returns):
-    if (ngems <= MAX_PLAYER_GEMS - DIFFERENT_COLOR_GEMS) {
-        addTakeGemCombination(moves, pid, board, diffColors, table, mine);
-    }
-
-    // Enumerate all legal moves that take and return gems (net zero change):
-    else if (ngems == MAX_PLAYER_GEMS) {
-        addTakeGemCombination(moves, pid, board, netAddZero1, table, mine);
-        addTakeGemCombination(moves, pid, board, netAddZero2, table, mine);
-    }
-
-    // Enumerate all legal moves that take and return gems (net one gem taken):
-    else if (ngems == MAX_PLAYER_GEMS - 1) {
-        addTakeGemCombination(moves, pid, board, netAddOne1, table, mine);
-        addTakeGemCombination(moves, pid, board, netAddOne2, table, mine);
-    }
-
-    // Enumerate all legal moves that take and return gems (net two gems taken):
-    else if (ngems == MAX_PLAYER_GEMS - 2) {
-        addTakeGemCombination(moves, pid, board, netAddTwo1, table, mine);
-        addTakeGemCombination(moves, pid, board, netAddTwo2, table, mine);
+    const auto& table = board.tableGems();
+    const auto& mine = board.playerGems(pid);
+    const auto ngems = mine.totalGems();
+    assert(ngems <= MAX_PLAYER_GEMS);
+
+    for (auto pattern = g_take_table.begin(ngems); pattern != g_take_table.end(ngems); ++pattern) {
+        if (pattern->isLegal(table, mine)) {
+            moves.push_back(pattern->move_);
+        }
     }
 }
 
 
 ///////////////////////////////////////////////////////////////////
-// Enumerate all the cards (table/reserves) we can afford to buy:
+// Enumerate all the cards (table/reserves) we can afford to buy. The board tells
+// which ones as a bitmask, so this is only a matter of testing bits, in pile order:
 static void
 addBuyCardMoves(Moves& moves, player_id_t pid, const Board& board)
 {
-    const auto& gems = board.playerGems(pid);
-    const auto& prestige = board.playerPrestige(pid);
+    const auto affordable = board.affordableCards(pid);
+    if (affordable.none()) {
+        return;
+    }
 
-    auto allCards = board.tableCards();
-    for (const auto c : board.playerReserves(pid)) {
-        if (!c.isWild()) {
-            allCards.push_back(c);
+    for (const auto idx : board.tableCards().indices()) {
+        if (affordable[idx]) {
+            moves.push_back(GameMove(idx, MoveType::BUY_CARD));
         }
     }
-
-    for (const auto& card : allCards) {
-        const auto balance = gems.actualCost(card.cost_ - prestige);
-        if (!((gems - balance).hasNegatives())) {
-            assert(!card.isWild());
-            assert(!card.isNull());
-            moves.push_back(GameMove(card, MoveType::BUY_CARD));
+    for (const auto idx : board.playerReserves(pid).indices()) {
+        if (idx < NCARDS && affordable[idx]) {
+            moves.push_back(GameMove(idx, MoveType::BUY_CARD));
         }
     }
 }
@@ -188,8 +124,8 @@ addReserveCardMoves(Moves& moves, player_id_t pid, const Board& board)
     }
 
     // Reserves from table cards:
-    for (const auto& card : board.tableCards()) {
-         moves.push_back(GameMove(card, MoveType::RESERVE_CARD));
+    for (const auto idx : board.tableCards().indices()) {
+         moves.push_back(GameMove(idx, MoveType::RESERVE_CARD));
     }
 
     // Reserves from undealt cards:
@@ -207,15 +143,22 @@ addReserveCardMoves(Moves& moves, player_id_t pid, const Board& board)
 
 ///////////////////////////////////////////////////////////////////
 // Accumulate legal moves of all four types:
+void
+legalMoves(const Board& board, player_id_t pid, Moves& moves)
+{
+    moves.clear();
+    addTakeGemMoves(moves, pid, board);
+    addBuyCardMoves(moves, pid, board);
+    addReserveCardMoves(moves, pid, board);
+}
+
+
+///////////////////////////////////////////////////////////////////
 Moves
 legalMoves(const Board& board, player_id_t pid)
 {
     Moves ret;
-
-    addTakeGemMoves(ret, pid, board);
-    addBuyCardMoves(ret, pid, board);
-    addReserveCardMoves(ret, pid, board);
-
+    legalMoves(board, pid, ret);
     return ret;
 }
 
@@ -236,20 +179,20 @@ makeMove(Board& board, player_id_t pid, const GameMove& mymove, const Card& repl
 {
     MoveStatus status = LEGAL_MOVE;
 
-    switch (mymove.type_) {
+    switch (mymove.type()) {
     case MoveType::TAKE_GEMS:
-        status = board.takeGems(pid, mymove.payload_.gems_);
+        status = board.takeGems(pid, mymove.gems());
         break;
 
     case MoveType::BUY_CARD:
-        assert(!mymove.payload_.card_.isWild());
-        assert(!mymove.payload_.card_.isNull());
-        status = board.buyCard(pid, mymove.payload_.card_.id_, replacement);
+        assert(!mymove.card().isWild());
+        assert(!mymove.card().isNull());
+        status = board.buyCard(pid, mymove.card().id_, replacement);
         break;
 
     case MoveType::RESERVE_CARD:
-        assert(!mymove.payload_.card_.isNull());
-        status = board.reserveCard(pid, mymove.payload_.card_, replacement);
+        assert(!mymove.card().isNull());
+        status = board.reserveCard(pid, mymove.card(), replacement);
         break;
     }
 
@@ -260,51 +203,61 @@ makeMove(Board& board, player_id_t pid, const GameMove& mymove, const Card& repl
 // Chose a move for a given player, find replacement card if necessary,
 // and execute the move.
 static MoveStatus
-playerMove(Board& board, player_id_t pid, Cards& deck,
-           const Player* player, const Moves& legal)
+playerMove(Board& board, player_id_t pid, Deck& deck,
+           const Player* player, const Moves& legal, const MoveNotifier& notifier,
+           GameContext& context)
 {
     if (legal.empty()) {
         return LEGAL_MOVE;
     }
 
-    auto pMove = player->getMove(board, legal);
+    auto pMove = player->getMove(board, legal, context);
+    if (!notifier.empty()) {
+        if (const auto stats = player->moveStats()) {
+            notifier.notifyObservers(MoveEvent::MOVE_STATS, board, pid, stats);
+        }
+    }
 
     // Find replacement card if buying/reserving from table:
     Card replacement = NULL_CARD;
-    Card payloadCard = pMove.payload_.card_;
+    Card payloadCard = (pMove.type() == TAKE_GEMS)? NULL_CARD : pMove.card();
 
 
-    switch (pMove.type_) {
+    switch (pMove.type()) {
     case TAKE_GEMS: break;    // No need to replace any cards
     case RESERVE_CARD:
         if (payloadCard.isWild()) {
-            payloadCard = popFromDeck(payloadCard.id_.type_, deck);
+            payloadCard = deck.draw(payloadCard.id_.type_);
             assert(!payloadCard.isNull());
         }
         // Fall through to next case:
     case BUY_CARD:
-        if (cardIn(pMove.payload_.card_.id_, board.tableCards())) {
-            replacement = popFromDeck(payloadCard.id_.type_, deck);
-            MoveNotifier::instance().notifyObservers(MoveEvent::REPLACEMENT_CARD, board, pid, replacement);
+        if (board.isOnTable(pMove.card())) {
+            replacement = deck.draw(payloadCard.id_.type_);
+            notifier.notifyObservers(MoveEvent::REPLACEMENT_CARD, board, pid, replacement);
         }
         break;
     }
 
-    const GameMove newMove = (pMove.type_ == TAKE_GEMS)?
+    const GameMove newMove = (pMove.type() == TAKE_GEMS)?
                              pMove :
-                             GameMove(payloadCard, pMove.type_);
+                             GameMove(payloadCard, pMove.type());
 
     const auto nobles = board.tableNobles();
     MoveStatus status = makeMove(board, pid, newMove, replacement);
     assert(status == LEGAL_MOVE);
+    assert(payloadCard.isNull()
+        || deck.size(payloadCard.id_.type_) == board.remainingCards(payloadCard.id_.type_));
+    if (notifier.empty()) {
+        return status;
+    }
 
-    MoveNotifier::instance().notifyObservers(
-            MoveEvent::MOVE_TAKEN, board, pid, { pMove });
+    notifier.notifyObservers(MoveEvent::MOVE_TAKEN, board, pid, { pMove });
     if (board.tableNobles() != nobles) {
         for (auto n : nobles) {
             if (board.tableNobles().cend() ==
                     find(board.tableNobles().cbegin(), board.tableNobles().cend(), n)) {
-                MoveNotifier::instance().notifyObservers(MoveEvent::NOBLE_WON, board, pid, n);
+                notifier.notifyObservers(MoveEvent::NOBLE_WON, board, pid, n);
             }
         }
     }
@@ -314,28 +267,47 @@ playerMove(Board& board, player_id_t pid, Cards& deck,
 
 
 ///////////////////////////////////////////////////////////////////
-player_id_t
-mainGameLoop(Board& board, Cards& deck, Players& players)
+// The game loop for a given no. of players, on a FixedBoard:
+template <unsigned NPLAYER>
+static player_id_t
+gameLoop(FixedBoard<NPLAYER>& board, Deck& deck, Players& players, const MoveNotifier& notifier,
+         GameContext& context)
 {
-    MoveNotifier::instance().notifyObservers(MoveEvent::GAME_BEGAN, board, 0);
+    notifier.notifyObservers(MoveEvent::GAME_BEGAN, board, 0);
 
     while (!board.gameOver()) {
         board.newRound();
-        for (player_id_t pid = 0; pid < board.playersNum(); ++pid) {
+        for (player_id_t pid = 0; pid < NPLAYER; ++pid) {
             const auto legal = legalMoves(board, pid);
-            playerMove(board, pid, deck, players[pid], legal);
+            playerMove(board, pid, deck, players[pid], legal, notifier, context);
         }
     }
 
     // End of game: find winner:
     const auto winner = board.leadingPlayer();
-    if (winner < board.playersNum()) {
-        MoveNotifier::instance().notifyObservers(MoveEvent::GAME_WON, board, winner);
+    if (winner < NPLAYER) {
+        notifier.notifyObservers(MoveEvent::GAME_WON, board, winner);
     } else {
-        MoveNotifier::instance().notifyObservers(MoveEvent::TIE, board, winner);
+        notifier.notifyObservers(MoveEvent::TIE, board, winner);
     }
     return winner;
 }
 
 
+///////////////////////////////////////////////////////////////////
+// The game is played on a FixedBoard copy of the board, which is copied back
+// when it's over:
+player_id_t
+mainGameLoop(Board& board, Deck& deck, Players& players, const MoveNotifier& notifier,
+             GameContext& context)
+{
+    return withPlayers(board.playersNum(), [&](auto nplayer) {
+        FixedBoard<decltype(nplayer)::value> fixed(board);
+        const auto winner = gameLoop(fixed, deck, players, notifier, context);
+        board = fixed;
+        return winner;
+    });
+}
+
+
 } // namespace
@@ -5,13 +5,16 @@
 
 #pragma once
 
-#include <iosfwd>
+#include <cassert>
+#include <cstdint>
 #include <functional>
+#include <iosfwd>
 #include <vector>
 
 #include "card.h"
 #include "constants.h"
 #include "gems.h"
+#include "static_vector.h"
 
 namespace grandeur {
 
@@ -34,30 +37,112 @@ enum MoveStatus {
 // A Game move consists of one of three move types, with an associated payload for each.
 // If the payload is gems, it can only be a TAKE_GEMS move type. If it's a card ID,
 // It can be either a BUY_CARD or RESERVE_CARD.
-struct GameMove {
-    constexpr GameMove(const Gems& gems) : type_(MoveType::TAKE_GEMS), payload_(gems) {}
-    constexpr GameMove(const Card& card, MoveType type) : type_(type), payload_(card) {}
-
-    bool operator==(const GameMove& rhs) const;
-
-    MoveType type_;
-    union payload {
-        Gems gems_;   // In case of TAKE_GEMS
-        Card card_;  // Otherwise
-        constexpr payload(const Gems& gems) : gems_(gems) {};
-        constexpr payload(const Card& card) : card_(card) {};
-    } payload_;
+//
+// Moves are encoded in 16 bits, so that move lists stay small and cache-friendly:
+// the type in the top two bits, and the payload in the rest. Gems to take are
+// encoded as the digits of a base-5 number, one per color, from -2 to 2 (which
+// covers every take, legal or not, that can be written as a move). Cards are
+// encoded as their card index (see card.h). The payload is decoded back into
+// gems or a card on demand.
+class GameMove {
+    friend struct GemDigits;
+
+  public:
+    constexpr GameMove(const Gems& gems) : code_(encode(TAKE_GEMS, gemsCode(gems))) {}
+    constexpr GameMove(const Card& card, MoveType type) : GameMove(cardIndex(card), type) {}
+    constexpr GameMove(card_index_t idx, MoveType type) : code_(encode(type, idx))
+    {
+        assert(type != TAKE_GEMS && idx < NCARD_INDICES);
+    }
+    constexpr GameMove() : GameMove(NULL_CARD, BUY_CARD) {}  // NULL_MOVE
+
+    bool operator==(const GameMove& rhs) const { return code_ == rhs.code_; }
+    bool operator!=(const GameMove& rhs) const { return code_ != rhs.code_; }
+
+    constexpr MoveType type() const { return MoveType(code_ >> PAYLOAD_BITS); }
+
+    // The gems to take (TAKE_GEMS moves only):
+    Gems gems() const;
+
+    // The card to buy or reserve (a wildcard if reserving from a deck), and its index:
+    const Card& card() const { return cardAt(index()); }
+    card_index_t index() const
+    {
+        assert(type() != TAKE_GEMS);
+        return code_ & ((1 << PAYLOAD_BITS) - 1);
+    }
+
+    // The raw 16-bit encoding:
+    constexpr uint16_t code() const { return code_; }
+
+  private:
+    static constexpr unsigned PAYLOAD_BITS = 14;
+    static constexpr int GEM_OFFSET = SAME_COLOR_GEMS;  // Most gems taken (or returned) per color
+    static constexpr int GEM_BASE = 2 * GEM_OFFSET + 1;
+
+    static constexpr uint16_t encode(MoveType type, unsigned payload)
+    {
+        return uint16_t((unsigned(type) << PAYLOAD_BITS) | payload);
+    }
+
+    static constexpr unsigned gemsCode(const Gems& gems)
+    {
+        unsigned ret = 0;
+        for (int color = NCOLOR - 1; color >= 0; --color) {
+            const int count = gems.getCount(gem_color_t(color));
+            assert(count >= -GEM_OFFSET && count <= GEM_OFFSET && "Can't encode gem count");
+            ret = ret * GEM_BASE + (count + GEM_OFFSET);
+        }
+        return ret;
+    }
+
+    uint16_t code_;
 };
 
+static_assert(sizeof(GameMove) == sizeof(uint16_t), "GameMove should be 16 bits");
+
 static constexpr GameMove NULL_MOVE(NULL_CARD, MoveType::BUY_CARD);
 
+
+//////////////////////////////////////////////////////////////////////////////
+// Decoding gems digit by digit is slow, so they're looked up in two tables instead:
+// one for the low three digits (colors), and one for the high three.
+struct GemDigits {
+    static constexpr unsigned SIZE = 125;  // GEM_BASE ** 3
+
+    constexpr GemDigits();
+
+    Gems low_[SIZE];
+    Gems high_[SIZE];
+};
+
+extern const GemDigits g_gem_digits;
+
+inline Gems
+GameMove::gems() const
+{
+    assert(type() == TAKE_GEMS);
+    const unsigned payload = code_ & ((1 << PAYLOAD_BITS) - 1);
+    return g_gem_digits.low_[payload % GemDigits::SIZE] + g_gem_digits.high_[payload / GemDigits::SIZE];
+}
+
+
 std::ostream& operator<<(std::ostream&, const GameMove&);
 
 
 using player_id_t = unsigned;
-using Moves = std::vector<GameMove>;
+
+// The most legal moves a player can ever have: 50 ways to take gems (with 10
+// gems, which rules out reserving), plus buying any of the 12 table cards and
+// 3 reserves. (With 8 gems: 35 ways to take gems, and 30 to buy or reserve.)
+static constexpr unsigned MAX_LEGAL_MOVES = 65;
+
+// Move lists are stored in place, so they never allocate memory:
+using Moves = StaticVector<GameMove, MAX_LEGAL_MOVES>;
 
 class Board;
+struct GameContext;
+class MoveNotifier;
 class Player;
 
 /////////////////////////////////////////////////////
@@ -82,8 +167,14 @@ MoveStatus isLegalMove(Board, player_id_t, const GameMove&);
 Moves
 legalMoves(const Board& board, player_id_t pid);
 
+// Same, but write the moves into a caller's list (replacing its contents):
+void
+legalMoves(const Board& board, player_id_t pid, Moves& moves);
+
 
-// mainGaimLoop is the run a complete game, start to finish
-player_id_t mainGameLoop(Board&, Cards&, std::vector<const Player*>&);
+// mainGaimLoop is the run a complete game, start to finish, notifying the
+// game's observers of every change. The players draw on the game's context.
+player_id_t mainGameLoop(Board&, Deck&, std::vector<const Player*>&, const MoveNotifier&,
+                         GameContext&);
 
 } // namespace
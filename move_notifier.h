@@ -1,10 +1,14 @@
-// MoveNotifier is a singleton that lets interested observers (e.g., players)
+// MoveNotifier lets interested observers (e.g., players) of a single game
 // register to receive notifications for any board changes. They register
 // a callback function that gets the new state of the Board, and if a move was
 // just made, the player who made it and the move.
 // There are two special cases when NULL_MOVE is passed: At the beginning of the
 // game, before any moves were made, and at the end of a game, with the winning
 // player passed as the moving player's pid (or an index too large if stalemate)
+// Players that collect search statistics report them (MOVE_STATS) right after
+// picking each move, before it's made.
+// Every game has its own MoveNotifier, so games can run concurrently in different
+// threads. Notifying a MoveNotifier without observers costs nothing.
 //
 // Created by eitan on 12/4/15.
 //
@@ -15,14 +19,20 @@
 #include "move.h"
 #include "noble.h"
 
+#include <functional>
+#include <vector>
+
 namespace grandeur {
 
+struct SearchStats;
+
 enum class MoveEvent { GAME_BEGAN = 0,   // Start a game
                        MOVE_TAKEN,       // A game move was made
                        NOBLE_WON,        // A noble was won
                        REPLACEMENT_CARD, // A new card was popped from the deck
                        GAME_WON,         // The game ended with a player winning
-                       TIE               // The game ended with nobody winning
+                       TIE,              // The game ended with nobody winning
+                       MOVE_STATS        // A player picked a move, searching this much
 };
 
 
@@ -33,42 +43,39 @@ class MoveNotifier {
         Payload(const GameMove& mv) : mv_(mv) {}
         Payload(const Noble& noble) : noble_(noble) {}
         Payload(const Card& card) : replacement_(card) {}
+        Payload(const SearchStats* stats) : stats_(stats) {}
         Payload() : mv_(NULL_MOVE) {}
 
         GameMove mv_;
         Noble noble_;
         Card replacement_;
+        const SearchStats* stats_;  // Valid only during the notification
     };
 
     using observer_t = std::function<
             void(MoveEvent, const Board&, player_id_t, const Payload&)>;
 
-    static MoveNotifier& instance()
-    {
-        static MoveNotifier singleton;
-        return singleton;
-    }
+    MoveNotifier() = default;
+    MoveNotifier(const MoveNotifier&) = delete;
+    MoveNotifier& operator=(const MoveNotifier&) = delete;
 
     void registerObserver(observer_t observer)
-    { observers_.push_back(observer); }
+    { observers_.push_back(std::move(observer)); }
+
+    // Does anybody listen? (If not, callers can skip preparing notifications)
+    bool empty() const { return observers_.empty(); }
 
     void notifyObservers(MoveEvent event, const Board& board, player_id_t pid,
-                         const Payload& payload = Payload())
+                         const Payload& payload = Payload()) const
     {
-        for (auto obs : observers_) {
+        for (const auto& obs : observers_) {
             obs(event, board, pid, payload);
         }
     }
 
 
   private:
-    std::vector <observer_t> observers_;
-
-    MoveNotifier() = default;
-
-    MoveNotifier(const MoveNotifier&) = delete;
-
-    MoveNotifier& operator=(const MoveNotifier&) = delete;
+    std::vector<observer_t> observers_;
 };
 
 
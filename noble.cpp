@@ -5,6 +5,8 @@
 
 #include "noble.h"
 
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 
 namespace grandeur {
@@ -16,6 +18,15 @@ operator==(const Noble& lhs, const Noble& rhs)
 }
 
 
+unsigned
+nobleIndex(const Noble& noble)
+{
+    const auto where = std::find(std::begin(g_nobles), std::end(g_nobles), noble);
+    assert(where != std::end(g_nobles));
+    return std::distance(std::begin(g_nobles), where);
+}
+
+
 std::ostream&
 operator<<(std::ostream& os, const Noble& noble)
 {
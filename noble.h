@@ -43,5 +43,10 @@ static constexpr const Noble g_nobles[] = {
         { { 0, 0, 4, 0, 4 }, 3 }    // 9
 };
 
+static constexpr unsigned NNOBLES = sizeof(g_nobles) / sizeof(g_nobles[0]);
+
+// Return the index of a noble in g_nobles:
+unsigned nobleIndex(const Noble& noble);
+
 
 } // namespace
\ No newline at end of file
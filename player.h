@@ -14,13 +14,24 @@
 
 namespace grandeur {
 
+struct GameContext;
+class MoveNotifier;
+struct SearchStats;
+
 class Player {
   public:
     Player(player_id_t pid) : pid_(pid) {}
     virtual ~Player() = default;
 
     // Main interface Player must satisfy: pick a game move for a given board.
-    virtual GameMove getMove(const Board& board, const Moves& legal) const = 0;
+    // Any randomness the player needs should come from the game's context.
+    virtual GameMove getMove(const Board& board, const Moves& legal, GameContext& context) const = 0;
+
+    // Register for notifications of the moves in a game this player takes part in:
+    virtual void subscribe(MoveNotifier&) const {}
+
+    // The statistics of the last getMove(), if this player collects any (or null):
+    virtual const SearchStats* moveStats() const { return nullptr; }
 
     player_id_t pid_;
 };
@@ -3,19 +3,17 @@
 //
 
 #include "random_player.h"
-#include "config.h"
+#include "game_context.h"
 
 #include <random>
 
 namespace grandeur {
 
-extern Config* g_config;
-
 GameMove
-RandomPlayer::getMove(const Board&, const Moves& legal) const
+RandomPlayer::getMove(const Board&, const Moves& legal, GameContext& context) const
 {
     std::uniform_int_distribution<> dist(0, legal.size() - 1);
-    return legal.at(dist(g_config->prng_));
+    return legal.at(dist(context.prng_));
 }
 
 static PlayerFactory::Registrator registrator("random",
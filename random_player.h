@@ -1,5 +1,5 @@
 // An implementation of a simple "AI" player that picks any legal move randomly.
-// Note: you can set the see for the PRNG with the environment variable GRANDEUR_PLAYER_SEED
+// It draws from the game's PRNG, so its moves are reproducible with the game's seed.
 //
 // Created by eitan on 12/2/15.
 //
@@ -13,7 +13,7 @@ namespace grandeur {
 class RandomPlayer final : public Player {
   public:
     RandomPlayer(player_id_t pid) : Player(pid) {}
-    virtual GameMove getMove(const Board& board, const Moves& legal) const;
+    virtual GameMove getMove(const Board& board, const Moves& legal, GameContext& context) const;
 };
 
 }  // namespace
@@ -0,0 +1,143 @@
+// Search statistics implementation
+//
+
+#include "search_stats.h"
+#include "game_context.h"
+
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+namespace grandeur {
+
+/////////////////////////////////////////////////////////////
+SearchStats&
+SearchStats::operator+=(const SearchStats& rhs)
+{
+    moves_ += rhs.moves_;
+    depth_ += rhs.depth_;
+    nodes_ += rhs.nodes_;
+    movesScored_ += rhs.movesScored_;
+    legalMovesCalls_ += rhs.legalMovesCalls_;
+    boardCopies_ += rhs.boardCopies_;
+    tasks_ += rhs.tasks_;
+    evalSeconds_ += rhs.evalSeconds_;
+    wallSeconds_ += rhs.wallSeconds_;
+    cpuSeconds_ += rhs.cpuSeconds_;
+    return *this;
+}
+
+
+/////////////////////////////////////////////////////////////
+SearchStats
+operator-(const SearchStats& after, const SearchStats& before)
+{
+    SearchStats ret;
+    ret.moves_ = after.moves_ - before.moves_;
+    ret.depth_ = after.depth_ - before.depth_;
+    ret.nodes_ = after.nodes_ - before.nodes_;
+    ret.movesScored_ = after.movesScored_ - before.movesScored_;
+    ret.legalMovesCalls_ = after.legalMovesCalls_ - before.legalMovesCalls_;
+    ret.boardCopies_ = after.boardCopies_ - before.boardCopies_;
+    ret.tasks_ = after.tasks_ - before.tasks_;
+    ret.evalSeconds_ = after.evalSeconds_ - before.evalSeconds_;
+    ret.wallSeconds_ = after.wallSeconds_ - before.wallSeconds_;
+    ret.cpuSeconds_ = after.cpuSeconds_ - before.cpuSeconds_;
+    return ret;
+}
+
+
+/////////////////////////////////////////////////////////////
+ostream&
+operator<<(ostream& os, const SearchStats& stats)
+{
+    const auto moves = max(1u, stats.moves_);
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << fixed << setprecision(1)
+       << "depth " << double(stats.depth_) / moves
+       << ", " << stats.nodes_ << " nodes (" << setprecision(0) << stats.nodesPerSecond() << "/sec)"
+       << ", branching " << setprecision(1) << stats.branching()
+       << ", " << stats.legalMovesCalls_ << " legalMoves calls"
+       << ", " << stats.boardCopies_ << " board copies"
+       << ", " << stats.tasks_ << " tasks"
+       << ", eval " << setprecision(3) << stats.evalSeconds_
+       << "s, wall " << stats.wallSeconds_ << "s";
+    if (stats.cpuSeconds_ > 0) {
+        os << ", cpu " << stats.cpuSeconds_ << "s";
+    }
+    os.flags(flags);
+    os.precision(precision);
+    return os;
+}
+
+
+/////////////////////////////////////////////////////////////
+SearchStats
+SearchCounters::read() const
+{
+    SearchStats ret;
+    for (const auto& counts : counts_) {
+        ret.nodes_ += counts.nodes_;
+        ret.movesScored_ += counts.movesScored_;
+        ret.legalMovesCalls_ += counts.legalMovesCalls_;
+        ret.boardCopies_ += counts.boardCopies_;
+        ret.tasks_ += counts.tasks_;
+        ret.evalSeconds_ += 1e-9 * counts.evalNanos_;
+    }
+    return ret;
+}
+
+
+/////////////////////////////////////////////////////////////
+double
+cpuSeconds()
+{
+    return double(clock()) / CLOCKS_PER_SEC;
+}
+
+
+/////////////////////////////////////////////////////////////
+MoveMeter::MoveMeter(SearchCounters& counters, const GameContext& context)
+  : counters_(counters), before_(counters.read()), start_(chrono::steady_clock::now()),
+    cpuStart_(context.alone_? cpuSeconds() : -1)
+{
+    counters.timed_ = context.stats_;
+}
+
+
+/////////////////////////////////////////////////////////////
+SearchStats
+MoveMeter::stats(unsigned depth) const
+{
+    auto ret = counters_.read() - before_;
+    ret.moves_ = 1;
+    ret.depth_ = depth;
+    ret.wallSeconds_ = chrono::duration<double>(chrono::steady_clock::now() - start_).count();
+    ret.cpuSeconds_ = (cpuStart_ >= 0)? cpuSeconds() - cpuStart_ : 0;
+    return ret;
+}
+
+
+/////////////////////////////////////////////////////////////
+Scores
+scoreMoves(const evaluator_t& eval, const Moves& moves, const player_id_t pid, const Board& board,
+           SearchCounters& counters)
+{
+    auto& counts = counters.local();
+    ++counts.nodes_;
+    counts.movesScored_ += moves.size();
+    counts.boardCopies_ += moves.size();
+    if (!counters.timed_) {
+        return computeScores(eval, moves, pid, board);
+    }
+
+    const auto start = chrono::steady_clock::now();
+    const auto scores = computeScores(eval, moves, pid, board);
+    counts.evalNanos_ += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    return scores;
+}
+
+} // namespace
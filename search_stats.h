@@ -0,0 +1,108 @@
+// SearchStats: what a player did to pick a move (or a game's worth of moves):
+// how many boards it searched, how much of its time went to scoring moves, and
+// how much of the machine it kept busy. Players that collect these report them
+// after every move through the game's MoveNotifier (as a MOVE_STATS event).
+//
+// A search's tasks count their work concurrently in SearchCounters, which the
+// player turns into a SearchStats per move. Every thread counts in its own
+// copy, so tasks don't contend for the counters, and the time spent scoring
+// moves is only measured if the game collects statistics (see GameContext).
+//
+
+#pragma once
+
+#include "eval.h"
+
+#include <tbb/cache_aligned_allocator.h>
+#include <tbb/enumerable_thread_specific.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+namespace grandeur {
+
+struct GameContext;
+
+struct SearchStats {
+    unsigned moves_ = 0;            // No. of moves picked
+    unsigned depth_ = 0;            // Depth of the search (summed over moves)
+    uint64_t nodes_ = 0;            // Search nodes (boards whose moves got scored)
+    uint64_t movesScored_ = 0;      // Moves scored at all these nodes
+    uint64_t legalMovesCalls_ = 0;  // Calls to legalMoves() during the search
+    uint64_t boardCopies_ = 0;      // Boards copied, to score moves or for parallel tasks
+    uint64_t tasks_ = 0;            // TBB task bodies run
+    double evalSeconds_ = 0;        // Time spent scoring moves (summed over threads)
+    double wallSeconds_ = 0;        // Elapsed time
+    double cpuSeconds_ = 0;         // Process CPU time (zero if other games ran concurrently)
+
+    SearchStats& operator+=(const SearchStats& rhs);
+
+    double nodesPerSecond() const { return wallSeconds_ > 0? nodes_ / wallSeconds_ : 0; }
+
+    // Mean no. of moves per node:
+    double branching() const { return nodes_? double(movesScored_) / nodes_ : 0; }
+
+    // How many threads were kept busy on average (zero if unknown):
+    double parallelism() const { return wallSeconds_ > 0? cpuSeconds_ / wallSeconds_ : 0; }
+};
+
+// A one-line summary of the statistics:
+std::ostream& operator<<(std::ostream& os, const SearchStats& stats);
+
+
+// Cumulative counters of a player's searches, which every thread updates in
+// its own Counts (on its own cache line):
+struct SearchCounters {
+    struct Counts {
+        uint64_t nodes_ = 0;
+        uint64_t movesScored_ = 0;
+        uint64_t legalMovesCalls_ = 0;
+        uint64_t boardCopies_ = 0;
+        uint64_t tasks_ = 0;
+        uint64_t evalNanos_ = 0;
+    };
+
+    // The counts of the calling thread:
+    Counts& local() { return counts_.local(); }
+
+    // Snapshot the counters (between searches), to subtract from a later snapshot:
+    SearchStats read() const;
+
+    bool timed_ = false;  // Measure the time spent scoring moves?
+
+  private:
+    tbb::enumerable_thread_specific<Counts, tbb::cache_aligned_allocator<Counts>,
+                                    tbb::ets_key_per_instance> counts_;
+};
+
+// The counters' difference between two snapshots, as the statistics of one move:
+SearchStats operator-(const SearchStats& after, const SearchStats& before);
+
+// Process CPU time so far, in seconds:
+double cpuSeconds();
+
+
+// Measures one move of a player, from the counters of its searches, which
+// it times if the game collects statistics. The process's CPU time is only
+// measured if no other game runs meanwhile:
+class MoveMeter {
+  public:
+    MoveMeter(SearchCounters& counters, const GameContext& context);
+
+    // The statistics of the move so far, from a search of this depth:
+    SearchStats stats(unsigned depth) const;
+
+  private:
+    const SearchCounters& counters_;
+    const SearchStats before_;
+    const std::chrono::steady_clock::time_point start_;
+    const double cpuStart_;  // (Negative if not measured)
+};
+
+
+// Like computeScores (without the new boards), but counted (and maybe timed) as a search node:
+Scores scoreMoves(const evaluator_t& eval, const Moves& moves, const player_id_t pid, const Board& board,
+                  SearchCounters& counters);
+
+} // namespace
@@ -0,0 +1,124 @@
+// StaticVector: a vector-like container with a fixed capacity, stored in place.
+// It never allocates memory, and it's trivially copyable (as long as its elements
+// are), so a class made of StaticVectors can be copied with a plain memcpy.
+// Only supports trivially-copyable element types.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+
+namespace grandeur {
+
+template <typename T, unsigned N>
+class StaticVector {
+    static_assert(std::is_trivially_copyable<T>::value, "StaticVector needs trivially-copyable elements");
+
+  public:
+    using value_type = T;
+    using size_type = unsigned;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    StaticVector() : size_(0) {}
+    StaticVector(std::initializer_list<T> init) : StaticVector(init.begin(), init.end()) {}
+
+    // n copies of a value:
+    StaticVector(unsigned n, const T& value) : size_(0)
+    {
+        while (size_ < n) {
+            push_back(value);
+        }
+    }
+
+    // Copy a range of elements (for iterator types only):
+    template <typename Iter>
+    StaticVector(Iter begin, Iter end, typename std::iterator_traits<Iter>::iterator_category* = nullptr)
+      : size_(0)
+    {
+        for (; begin != end; ++begin) {
+            push_back(*begin);
+        }
+    }
+
+    static constexpr unsigned capacity() { return N; }
+    void reserve(unsigned n) const { assert(n <= N && "StaticVector capacity exceeded"); (void)n; }
+    unsigned size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + size_; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size_; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    T& operator[](unsigned idx) { assert(idx < size_); return data()[idx]; }
+    const T& operator[](unsigned idx) const { assert(idx < size_); return data()[idx]; }
+    T& at(unsigned idx) { return (*this)[idx]; }
+    const T& at(unsigned idx) const { return (*this)[idx]; }
+    T& front() { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T& back() { return (*this)[size_ - 1]; }
+    const T& back() const { return (*this)[size_ - 1]; }
+
+    void push_back(const T& value)
+    {
+        assert(size_ < N && "StaticVector capacity exceeded");
+        new (data() + size_) T(value);
+        ++size_;
+    }
+
+    void pop_back() { assert(size_ > 0); --size_; }
+    void clear() { size_ = 0; }
+
+    // Insert an element before pos, shifting the rest of the elements up:
+    iterator insert(const_iterator pos, const T& value)
+    {
+        assert(size_ < N && "StaticVector capacity exceeded");
+        const auto where = begin() + (pos - cbegin());
+        assert(where >= begin() && where <= end());
+        if (where == end()) {
+            push_back(value);
+        } else {
+            push_back(back());
+            std::copy_backward(where, end() - 2, end() - 1);
+            *where = value;
+        }
+        return where;
+    }
+
+    // Remove elements, shifting the rest of the elements down:
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const auto where = begin() + (first - cbegin());
+        assert(where >= begin() && last <= cend() && first <= last);
+        std::copy(begin() + (last - cbegin()), end(), where);
+        size_ -= last - first;
+        return where;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    bool operator==(const StaticVector& rhs) const
+    {
+        return size_ == rhs.size_ && std::equal(begin(), end(), rhs.begin());
+    }
+    bool operator!=(const StaticVector& rhs) const { return !(*this == rhs); }
+
+  private:
+    T* data() { return reinterpret_cast<T*>(storage_); }
+    const T* data() const { return reinterpret_cast<const T*>(storage_); }
+
+    unsigned size_;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_[N];
+};
+
+} // namespace
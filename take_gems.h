@@ -0,0 +1,161 @@
+// The ways a player can take gems from the table, computed at compile time.
+// A take pattern says how many gems of each color to take (or, when the player
+// would exceed MAX_PLAYER_GEMS, to return, as a negative count). Which patterns
+// apply depends only on how many gems the player already has, so they're stored
+// in one row per gem total. Every row lists its patterns in the order legalMoves()
+// has always produced them: grouped by the combination of counts, and each
+// group in lexicographic (std::next_permutation) order.
+//
+// Whether a pattern is legal on a given board is then a matter of two lane-wise
+// (SWAR) subtractions of gem words, with no loops over colors.
+//
+
+#pragma once
+
+#include "constants.h"
+#include "gems.h"
+#include "move.h"
+
+#include <cassert>
+
+namespace grandeur {
+
+struct TakePattern {
+    Gems take_;  // The gems taken (negative for gems returned)
+    Gems need_;  // The least table gems that allow this take
+    Gems give_;  // The gems returned, as positive counts
+    GameMove move_;  // The encoded move of taking take_
+
+    // Can this pattern be taken from the table by a player with these gems?
+    bool isLegal(const Gems& table, const Gems& mine) const
+    {
+        return !(table - need_).hasNegatives() && !(mine - give_).hasNegatives();
+    }
+};
+
+
+class TakeTable {
+  public:
+    static constexpr unsigned NROWS = 4;          // Up to 7 gems, then 8, 9, and 10
+    static constexpr unsigned MAX_PATTERNS = 50;  // Most patterns in a row (with 10 gems)
+
+    constexpr TakeTable();
+
+    // The patterns of a player who has ngems gems:
+    constexpr const TakePattern* begin(int ngems) const { return patterns_[row(ngems)]; }
+    constexpr const TakePattern* end(int ngems) const { return begin(ngems) + size_[row(ngems)]; }
+    constexpr unsigned size(int ngems) const { return size_[row(ngems)]; }
+
+  private:
+    static constexpr unsigned FIRST_ROW_GEMS = MAX_PLAYER_GEMS - NROWS + 1;
+
+    // Five gem counts, one per (non-yellow) color:
+    struct Counts {
+        gem_count_t c_[NCOLOR - 1];
+    };
+
+    static constexpr unsigned row(int ngems)
+    {
+        return (ngems < int(FIRST_ROW_GEMS))? 0 : ngems - FIRST_ROW_GEMS;
+    }
+
+    // Rearrange counts to their next lexicographic permutation, like
+    // std::next_permutation (which isn't constexpr). Returns false after the last.
+    static constexpr bool nextPermutation(Counts& counts);
+
+    // Add all the permutations of a combination of counts (sorted ascending) to a row:
+    constexpr void addPermutations(unsigned row, Counts counts);
+
+    TakePattern patterns_[NROWS][MAX_PATTERNS];
+    unsigned size_[NROWS];
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+constexpr bool
+TakeTable::nextPermutation(Counts& counts)
+{
+    constexpr int n = NCOLOR - 1;
+    int i = n - 2;
+    while (i >= 0 && counts.c_[i] >= counts.c_[i + 1]) {
+        --i;
+    }
+    if (i < 0) {
+        return false;
+    }
+
+    int j = n - 1;
+    while (counts.c_[j] <= counts.c_[i]) {
+        --j;
+    }
+    const auto tmp = counts.c_[i];
+    counts.c_[i] = counts.c_[j];
+    counts.c_[j] = tmp;
+
+    for (int lo = i + 1, hi = n - 1; lo < hi; ++lo, --hi) {
+        const auto tmp = counts.c_[lo];
+        counts.c_[lo] = counts.c_[hi];
+        counts.c_[hi] = tmp;
+    }
+    return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Taking two gems of a color requires MIN_SAME_COLOR_TABLE_GEMS of it on the table:
+constexpr void
+TakeTable::addPermutations(unsigned row, Counts counts)
+{
+    do {
+        Counts need = {}, give = {};
+        for (unsigned i = 0; i < NCOLOR - 1; ++i) {
+            const auto take = counts.c_[i];
+            need.c_[i] = (take == SAME_COLOR_GEMS)? MIN_SAME_COLOR_TABLE_GEMS : (take > 0)? take : 0;
+            give.c_[i] = (take < 0)? -take : 0;
+        }
+
+        auto& pattern = patterns_[row][size_[row]++];
+        pattern.take_ = Gems(counts.c_[0], counts.c_[1], counts.c_[2], counts.c_[3], counts.c_[4]);
+        pattern.need_ = Gems(need.c_[0], need.c_[1], need.c_[2], need.c_[3], need.c_[4]);
+        pattern.give_ = Gems(give.c_[0], give.c_[1], give.c_[2], give.c_[3], give.c_[4]);
+        pattern.move_ = GameMove(pattern.take_);
+    } while (nextPermutation(counts));
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// A player may take two gems of a color, or three of different colors, as long as
+// the total doesn't exceed MAX_PLAYER_GEMS. Otherwise, some gems must be returned.
+constexpr TakeTable::TakeTable()
+  : patterns_{}, size_{}
+{
+    constexpr Counts sameColor =   { {  0,  0,  0,  0,  2 } };
+    constexpr Counts diffColors =  { {  0,  0,  1,  1,  1 } };
+    constexpr Counts netAddZero1 = { { -2,  0,  0,  0,  2 } };
+    constexpr Counts netAddZero2 = { { -1, -1,  0,  1,  1 } };
+    constexpr Counts netAddOne1 =  { { -1,  0,  0,  0,  2 } };
+    constexpr Counts netAddOne2 =  { { -1, -1,  1,  1,  1 } };
+    constexpr Counts netAddTwo1 =  { { -1,  0,  1,  1,  1 } };
+    constexpr Counts netAddTwo2 =  { {  0,  0,  0,  1,  1 } };
+
+    // Up to 7 gems:
+    addPermutations(0, sameColor);
+    addPermutations(0, diffColors);
+
+    // 8 gems: two of a color, or three different ones and return one:
+    addPermutations(1, sameColor);
+    addPermutations(1, netAddTwo1);
+    addPermutations(1, netAddTwo2);
+
+    // 9 gems:
+    addPermutations(2, netAddOne1);
+    addPermutations(2, netAddOne2);
+
+    // 10 gems:
+    addPermutations(3, netAddZero1);
+    addPermutations(3, netAddZero2);
+}
+
+extern const TakeTable g_take_table;
+
+} // namespace
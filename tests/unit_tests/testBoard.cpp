@@ -10,37 +10,43 @@
 #include "gtest/gtest.h"
 
 #include "board.h"
+#include "game_context.h"
 #include "move.h"
+#include "move_notifier.h"
+#include "player.h"
+#include "take_gems.h"
+
+#include <tbb/parallel_for.h>
 
 using namespace grandeur;
 using namespace std;
 
 // Utility functions:
 // Count the no. of moves of each type in a collection of moves:
-unsigned take2MovesNum(const vector<GameMove>& moves)
+unsigned take2MovesNum(const Moves& moves)
 {
     return count_if(moves.cbegin(), moves.cend(), [](const GameMove& mv) {
-        return (mv.type_ == MoveType::TAKE_GEMS
-                && mv.payload_.gems_.positiveColors() == 1) ? 1 : 0;
+        return (mv.type() == MoveType::TAKE_GEMS
+                && mv.gems().positiveColors() == 1) ? 1 : 0;
     });
 }
-unsigned take3MovesNum(const vector<GameMove>& moves)
+unsigned take3MovesNum(const Moves& moves)
 {
     return count_if(moves.cbegin(), moves.cend(), [](const GameMove& mv) {
-        return (mv.type_ == MoveType::TAKE_GEMS
-                && mv.payload_.gems_.positiveColors() == 3) ? 1 : 0;
+        return (mv.type() == MoveType::TAKE_GEMS
+                && mv.gems().positiveColors() == 3) ? 1 : 0;
     });
 }
-unsigned buyMovesNum(const vector<GameMove>& moves)
+unsigned buyMovesNum(const Moves& moves)
 {
     return count_if(moves.cbegin(), moves.cend(), [](const GameMove& mv) {
-        return (mv.type_ == MoveType::BUY_CARD)? 1 : 0;
+        return (mv.type() == MoveType::BUY_CARD)? 1 : 0;
     });
 }
-unsigned reserveMovesNum(const vector<GameMove>& moves)
+unsigned reserveMovesNum(const Moves& moves)
 {
     return count_if(moves.cbegin(), moves.cend(), [](const GameMove& mv) {
-        return (mv.type_ == MoveType::RESERVE_CARD)? 1 : 0;
+        return (mv.type() == MoveType::RESERVE_CARD)? 1 : 0;
     });
 }
 
@@ -52,7 +58,7 @@ TEST(boardTests, ctor)
                   g_deck[70], g_deck[71], g_deck[72], g_deck[73] });
     Board board(2, cards, { g_nobles[5], g_nobles[6], g_nobles[7], g_nobles[8] });
 
-    EXPECT_EQ(board.tableCards(), cards);
+    EXPECT_EQ(Cards(board.tableCards().cbegin(), board.tableCards().cend()), cards);
 
     EXPECT_TRUE(board.playerReserves(0).empty());
     EXPECT_TRUE(board.playerReserves(1).empty());
@@ -140,6 +146,55 @@ TEST_F(MidGameBoard, correctReserves)
 }
 
 
+// Cards on the table, reserved, or purchased aren't undealt:
+TEST_F(MidGameBoard, cardLocations)
+{
+    for (const auto& card : board_.tableCards()) {
+        EXPECT_TRUE(board_.isOnTable(card));
+        EXPECT_FALSE(board_.isUndealt(card));
+    }
+    EXPECT_FALSE(board_.isOnTable(g_deck[42]));  // Reserved
+    EXPECT_FALSE(board_.isUndealt(g_deck[42]));
+    EXPECT_FALSE(board_.isOnTable(g_deck[0]));   // Purchased
+    EXPECT_FALSE(board_.isUndealt(g_deck[0]));
+    EXPECT_TRUE(board_.isUndealt(g_deck[50]));
+    EXPECT_FALSE(board_.isOnTable(LOW_CARD));
+
+    for (const auto dt : { LOW, MEDIUM, HIGH }) {
+        const auto undealt = board_.undealtCards(dt);
+        for (const auto& card : g_deck) {
+            EXPECT_EQ(card.id_.type_ == dt && board_.isUndealt(card), undealt[card.id_.seq_]);
+        }
+    }
+}
+
+TEST_F(MidGameBoard, affordableCards)
+{
+    const auto checkAll = [&]() {
+        for (player_id_t pid = 0; pid < nplayer_; ++pid) {
+            CardMask buyable;
+            for (const auto& card : board_.tableCards()) {
+                buyable[card.id_.seq_] = (LEGAL_MOVE == isLegalMove(board_, pid, GameMove(card, BUY_CARD)));
+            }
+            for (const auto& card : board_.playerReserves(pid)) {
+                buyable[card.id_.seq_] = (LEGAL_MOVE == isLegalMove(board_, pid, GameMove(card, BUY_CARD)));
+            }
+            EXPECT_EQ(buyable, board_.affordableCards(pid)) << "Player " << pid;
+        }
+    };
+
+    checkAll();
+    EXPECT_FALSE(board_.affordableCards(0)[42]);  // Six gems short, with two yellows
+
+    TAKE(0, Gems({ 0, 0, 2, 0, 0 }));
+    TAKE(0, Gems({ 0, 1, 1, 1, 0 }));
+    checkAll();
+    EXPECT_TRUE(board_.affordableCards(0)[42]);   // One gem short, with two yellows
+    EXPECT_FALSE(board_.affordableCards(1)[42]);  // Not in player 1's reserves
+    EXPECT_FALSE(board_.affordableCards(0)[0]);   // Purchased
+}
+
+
 TEST_F(MidGameBoard, correctGems)
 {
     EXPECT_EQ(board_.tableGems(),   Gems({ 4, 5, 5, 3, 5, 3 }));
@@ -175,6 +230,72 @@ TEST_F(MidGameBoard, correctRemainingDecks)
 }
 
 
+// Check the precomputed take patterns: every one is distinct, and none can
+// leave a player with too many gems:
+TEST(takeTable, patterns)
+{
+  const unsigned expectedSizes[] = { 15, 15, 15, 15, 15, 15, 15, 15, 35, 30, 50 };
+  for (int ngems = 0; ngems <= MAX_PLAYER_GEMS; ++ngems) {
+    EXPECT_EQ(expectedSizes[ngems], g_take_table.size(ngems));
+    for (auto p = g_take_table.begin(ngems); p != g_take_table.end(ngems); ++p) {
+      EXPECT_GE(p->take_.totalGems(), 0);
+      EXPECT_LE(ngems + p->take_.totalGems(), MAX_PLAYER_GEMS);
+      EXPECT_FALSE((p->take_ + p->give_).hasNegatives());
+      for (auto q = p + 1; q != g_take_table.end(ngems); ++q) {
+        EXPECT_NE(p->take_, q->take_);
+      }
+    }
+  }
+}
+
+
+// Check that the compact move encoding decodes back to the same gems or cards,
+// and that different moves never share a code:
+TEST(gameMove, encoding)
+{
+  EXPECT_EQ(2, sizeof(GameMove));
+
+  std::vector<GameMove> moves;
+  for (int ngems = 0; ngems <= MAX_PLAYER_GEMS; ++ngems) {
+    for (auto p = g_take_table.begin(ngems); p != g_take_table.end(ngems); ++p) {
+      EXPECT_EQ(TAKE_GEMS, p->move_.type());
+      EXPECT_EQ(p->take_, p->move_.gems());
+      EXPECT_EQ(p->move_, GameMove(p->take_));
+      if (std::find(moves.cbegin(), moves.cend(), p->move_) == moves.cend()) {
+        moves.push_back(p->move_);
+      }
+    }
+  }
+  const Gems yellow = { 0, 0, 0, 1, -1, -1 };
+  EXPECT_EQ(yellow, GameMove(yellow).gems());
+  moves.push_back(GameMove(yellow));
+
+  for (const auto type : { BUY_CARD, RESERVE_CARD }) {
+    for (const auto& card : g_deck) {
+      const GameMove mv(card, type);
+      EXPECT_EQ(type, mv.type());
+      EXPECT_EQ(card.id_, mv.card().id_);
+      EXPECT_EQ(card.cost_, mv.card().cost_);
+      moves.push_back(mv);
+    }
+  }
+  for (const auto& card : { LOW_CARD, MEDIUM_CARD, HIGH_CARD }) {
+    const GameMove mv(card, RESERVE_CARD);
+    EXPECT_TRUE(mv.card().isWild());
+    EXPECT_EQ(card.id_.type_, mv.card().id_.type_);
+    moves.push_back(mv);
+  }
+  EXPECT_TRUE(NULL_MOVE.card().isNull());
+  moves.push_back(NULL_MOVE);
+
+  for (unsigned i = 0; i < moves.size(); ++i) {
+    for (unsigned j = i + 1; j < moves.size(); ++j) {
+      EXPECT_NE(moves[i].code(), moves[j].code());
+    }
+  }
+}
+
+
 // Check that all (and only) the legal moves show up with legalMoves()
 TEST_F(MidGameBoard, legalMoves)
 {
@@ -424,3 +545,186 @@ TEST_F(MidGameBoard, nobleAcquisition)
     EXPECT_EQ(board_.playerPoints(2), 7);  // Points from getting the nobles 5 and 8
     ASSERT_EQ(board_.tableNobles().size(), nobles_.size() - 2);
 }
+
+
+// Different move orders that reach the same board must reach the same hash:
+TEST_F(MidGameBoard, hashTranspositions)
+{
+    Board b1 = board_, b2 = board_;
+    EXPECT_EQ(b1.hash(0), board_.hash(0));
+    EXPECT_NE(b1.hash(0), b1.hash(1));
+
+    EXPECT_EQ(LEGAL_MOVE, b1.takeGems(2, Gems({ 1, 1, 1, 0, 0 })));
+    EXPECT_EQ(LEGAL_MOVE, b1.takeGems(2, Gems({ 0, 0, 1, 1, 1 })));
+    EXPECT_EQ(LEGAL_MOVE, b2.takeGems(2, Gems({ 0, 0, 1, 1, 1 })));
+    EXPECT_NE(b1.hash(0), b2.hash(0));
+    EXPECT_EQ(LEGAL_MOVE, b2.takeGems(2, Gems({ 1, 1, 1, 0, 0 })));
+    EXPECT_EQ(b1.hash(0), b2.hash(0));
+    EXPECT_NE(b1.hash(0), board_.hash(0));
+
+    EXPECT_EQ(LEGAL_MOVE, b1.reserveCard(0, LOW_CARD));
+    EXPECT_EQ(LEGAL_MOVE, b1.buyCard(2, g_deck[12].id_, g_deck[13]));
+    EXPECT_EQ(LEGAL_MOVE, b2.buyCard(2, g_deck[12].id_, g_deck[13]));
+    EXPECT_NE(b1.hash(0), b2.hash(0));
+    EXPECT_EQ(LEGAL_MOVE, b2.reserveCard(0, LOW_CARD));
+    EXPECT_EQ(b1.hash(0), b2.hash(0));
+
+    b1.newRound();
+    EXPECT_NE(b1.hash(0), b2.hash(0));
+}
+
+
+// Compare all the visible elements of two boards:
+static void
+expectSameBoard(const Board& expected, const Board& actual)
+{
+    EXPECT_EQ(expected.tableCards(), actual.tableCards());
+    EXPECT_EQ(expected.tableGems(), actual.tableGems());
+    EXPECT_EQ(expected.tableNobles(), actual.tableNobles());
+    EXPECT_EQ(expected.roundNumber(), actual.roundNumber());
+    for (unsigned dt = LOW; dt <= HIGH; ++dt) {
+        EXPECT_EQ(expected.remainingCards(dt), actual.remainingCards(dt));
+    }
+    for (player_id_t pid = 0; pid < expected.playersNum(); ++pid) {
+        EXPECT_EQ(expected.playerGems(pid), actual.playerGems(pid));
+        EXPECT_EQ(expected.playerPrestige(pid), actual.playerPrestige(pid));
+        EXPECT_EQ(expected.playerPoints(pid), actual.playerPoints(pid));
+        EXPECT_EQ(expected.playerReserves(pid), actual.playerReserves(pid));
+        EXPECT_EQ(expected.hash(pid), actual.hash(pid));
+    }
+}
+
+
+// Undoing any legal move (and a new round) must restore the board exactly:
+TEST_F(MidGameBoard, applyUndo)
+{
+    const Board orig = board_;
+    const Card replacements[] = { g_deck[30], g_deck[60], g_deck[85] };
+
+    for (player_id_t pid = 0; pid < nplayer_; ++pid) {
+        for (const auto& mv : legalMoves(board_, pid)) {
+            auto replacement = NULL_CARD;
+            if (mv.type() != TAKE_GEMS && cardIn(mv.card().id_, board_.tableCards())) {
+                replacement = replacements[mv.card().id_.type_];
+            }
+
+            Board expected = board_;
+            EXPECT_EQ(LEGAL_MOVE, makeMove(expected, pid, mv, replacement));
+            const auto undo = board_.apply(pid, mv, replacement);
+            expectSameBoard(expected, board_);
+
+            board_.newRound();
+            board_.undo(undo);
+            expectSameBoard(orig, board_);
+        }
+    }
+}
+
+
+// Moves that win nobles, from table and reserves, undone in reverse order:
+TEST_F(MidGameBoard, undoNobles)
+{
+    const vector<pair<GameMove, Card>> moves = {
+        { Gems({ 0, 0, 2 }), NULL_CARD },
+        { Gems({ 1, 0, 1, 1 }), NULL_CARD },
+        { GameMove(g_deck[6], BUY_CARD), g_deck[19] },
+        { Gems({ 0, 0, 2 }), NULL_CARD },
+        { GameMove(g_deck[4], BUY_CARD), g_deck[20] },
+        { GameMove(g_deck[12], BUY_CARD), g_deck[13] },
+        { Gems({ 0, 0, 2 }), NULL_CARD },
+        { GameMove(g_deck[13], BUY_CARD), g_deck[14] },
+        { GameMove(g_deck[14], RESERVE_CARD), g_deck[11] },
+        { GameMove(g_deck[14], BUY_CARD), NULL_CARD },
+        { Gems({ 0, 0, 2 }), NULL_CARD },
+        { Gems({ 1, 1, 1 }), NULL_CARD },
+        { GameMove(g_deck[11], BUY_CARD), g_deck[21] },
+        { GameMove(g_deck[21], BUY_CARD), g_deck[23] },
+        { Gems({ 1, 0, 1, 1, 0 }), NULL_CARD },
+        { GameMove(g_deck[19], BUY_CARD), NULL_CARD },
+        { Gems({ 0, 0, 2 }), NULL_CARD },
+        { Gems({ 1, 0, 1, 1, 0 }), NULL_CARD },
+        { GameMove(g_deck[23], BUY_CARD), NULL_CARD },
+        { GameMove(g_deck[20], BUY_CARD), NULL_CARD }
+    };
+
+    vector<Board> boards;
+    vector<Board::UndoRecord> undos;
+    for (const auto& mv : moves) {
+        boards.push_back(board_);
+        undos.push_back(board_.apply(2, mv.first, mv.second));
+    }
+    EXPECT_EQ(board_.playerPoints(2), 7);
+    ASSERT_EQ(board_.tableNobles().size(), nobles_.size() - 2);
+
+    while (!undos.empty()) {
+        board_.undo(undos.back());
+        expectSameBoard(boards.back(), board_);
+        undos.pop_back();
+        boards.pop_back();
+    }
+}
+
+
+
+// A trivial, deterministic player:
+class FirstMovePlayer final : public Player {
+  public:
+    FirstMovePlayer(player_id_t pid) : Player(pid) {}
+    virtual GameMove getMove(const Board&, const Moves& legal, GameContext&) const
+    {
+        return legal.front();
+    }
+};
+
+// A player that picks moves with the game's PRNG:
+class AnyMovePlayer final : public Player {
+  public:
+    AnyMovePlayer(player_id_t pid) : Player(pid) {}
+    virtual GameMove getMove(const Board&, const Moves& legal, GameContext& context) const
+    {
+        return legal[context.prng_() % legal.size()];
+    }
+};
+
+// Play one game with a given deck order and PRNG seed, and count its notifications:
+static vector<unsigned>
+playGame(unsigned seed)
+{
+    Cards cards(begin(g_deck), end(g_deck));
+    rotate(cards.begin(), cards.begin() + seed % cards.size(), cards.end());
+    Deck deck(cards);
+    Cards initial;
+    for (int dt = LOW; dt <= HIGH; ++dt) {
+        for (unsigned i = 0; i < INITIAL_DECK_NCARD; ++i) {
+            initial.push_back(deck.draw(deck_t(dt)));
+        }
+    }
+    Board board(2, initial, { g_nobles[seed % 4], g_nobles[4], g_nobles[9] });
+
+    const FirstMovePlayer p0(0);
+    const AnyMovePlayer p1(1);
+    Players players = { &p0, &p1 };
+    vector<unsigned> counts(unsigned(MoveEvent::TIE) + 1, 0);
+    MoveNotifier notifier;
+    notifier.registerObserver([&](MoveEvent event, const Board&, player_id_t, const MoveNotifier::Payload&)
+                              { ++counts[unsigned(event)]; });
+    GameContext context(seed);
+    counts.push_back(mainGameLoop(board, deck, players, notifier, context));
+    return counts;
+}
+
+// Games running concurrently each notify only their own observers, and
+// draw only from their own PRNG, so they play out exactly like sequential games:
+TEST(gameLoop, concurrentGames)
+{
+    static constexpr unsigned ngames = 16;
+    vector<vector<unsigned>> sequential, parallel(ngames);
+    for (unsigned seed = 0; seed < ngames; ++seed) {
+        sequential.push_back(playGame(seed));
+        EXPECT_EQ(sequential.back()[unsigned(MoveEvent::GAME_BEGAN)], 1);
+        EXPECT_GT(sequential.back()[unsigned(MoveEvent::MOVE_TAKEN)], 0);
+    }
+
+    tbb::parallel_for(0u, ngames, [&](unsigned seed) { parallel[seed] = playGame(seed); });
+    EXPECT_EQ(sequential, parallel);
+}
@@ -8,6 +8,7 @@
 #include "card.h"
 
 #include <algorithm>
+#include <random>
 
 using namespace grandeur;
 using namespace std;
@@ -31,4 +32,74 @@ TEST(cardTests, correctSize)
     EXPECT_EQ(deckCount(LOW, g_deck), 40);
     EXPECT_EQ(deckCount(MEDIUM, g_deck), 30);
     EXPECT_EQ(deckCount(HIGH, g_deck), 20);
-}
\ No newline at end of file
+}
+// Check that card indices map back to the same cards, and that the card table
+// holds their attributes:
+TEST(cardTests, cardIndices)
+{
+    for (unsigned i = 0; i < NCARDS; ++i) {
+        EXPECT_EQ(i, cardIndex(g_deck[i]));
+        EXPECT_EQ(g_deck[i].id_, cardAt(i).id_);
+        EXPECT_EQ(g_deck[i].cost_, g_card_table.cost_[i]);
+        EXPECT_EQ(g_deck[i].color_, g_card_table.color_[i]);
+        EXPECT_EQ(g_deck[i].points_, g_card_table.points_[i]);
+        EXPECT_EQ(g_deck[i].id_.type_, g_card_table.deck_[i]);
+    }
+
+    for (const auto& card : { LOW_CARD, MEDIUM_CARD, HIGH_CARD, NULL_CARD }) {
+        const auto idx = cardIndex(card);
+        EXPECT_GE(idx, NCARDS);
+        EXPECT_LT(idx, NCARD_INDICES);
+        EXPECT_EQ(card.id_, cardAt(idx).id_);
+    }
+}
+
+
+// Compare the cost masks against paying for each card, with up to four gems of
+// every color and up to three yellows:
+TEST(cardTests, costMasks)
+{
+    for (unsigned i = 0; i < 5 * 5 * 5 * 5 * 5 * 4; ++i) {
+        gem_count_t counts[NCOLOR];
+        for (unsigned color = 0, n = i; color < NCOLOR; ++color, n /= 5) {
+            counts[color] = n % 5;
+        }
+        const Gems gems(begin(counts), end(counts));
+        const auto beyond = g_cost_masks.beyondReach(gems);
+        for (unsigned idx = 0; idx < NCARDS; ++idx) {
+            ASSERT_EQ(!gems.canPay(g_card_table.cost_[idx]), beyond[idx]) << gems << " for card " << idx;
+        }
+    }
+}
+
+
+// A deck draws the cards of each type in the order they were shuffled, until
+// it runs out:
+TEST(cardTests, deckDraws)
+{
+    mt19937_64 prng(7);
+    Cards shuffled(begin(g_deck), end(g_deck));
+    shuffle(begin(shuffled), end(shuffled), prng);
+
+    Deck deck(shuffled);
+    for (int dt = LOW; dt <= HIGH; ++dt) {
+        EXPECT_EQ(deckCount(deck_t(dt), g_deck), deck.size(deck_t(dt)));
+    }
+    for (const auto& card : shuffled) {
+        EXPECT_EQ(card.id_, deck.draw(card.id_.type_).id_);
+    }
+    for (int dt = LOW; dt <= HIGH; ++dt) {
+        EXPECT_EQ(0u, deck.size(deck_t(dt)));
+        EXPECT_TRUE(deck.draw(deck_t(dt)).isNull());
+    }
+
+    // Shuffling from the same seed deals the same deck:
+    mt19937_64 prng2(7);
+    Deck same(prng2);
+    Deck expected(shuffled);
+    for (int dt = LOW; dt <= HIGH; ++dt) {
+        while (expected.size(deck_t(dt)) > 0) {
+            EXPECT_EQ(expected.draw(deck_t(dt)).id_, same.draw(deck_t(dt)).id_);
+        }
+    }
+}
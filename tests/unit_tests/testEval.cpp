@@ -7,6 +7,7 @@
 
 #include "board.h"
 #include "eval.h"
+#include "fused_eval.h"
 #include "move.h"
 
 #include <algorithm>
@@ -139,7 +140,7 @@ TEST_F(LateGameBoard, countPrestige)
 
     const auto scores = playerScores(1, countPrestige);
     for (unsigned i = 0; i < moves1_.size(); ++i) {
-        EXPECT_EQ(scores[i], moves1_[i].type_ == BUY_CARD? 1 : 0);
+        EXPECT_EQ(scores[i], moves1_[i].type() == BUY_CARD? 1 : 0);
     }
 }
 
@@ -169,16 +170,16 @@ TEST_F(LateGameBoard, countGems)
         for (unsigned i = 0; i < moves.size(); ++i) {
             const auto mv = moves[i];
             score_t newGems = 0;
-            switch (mv.type_) {
+            switch (mv.type()) {
             case TAKE_GEMS:
-                newGems = curGems + mv.payload_.gems_.totalGems();
+                newGems = curGems + mv.gems().totalGems();
                 break;
             case RESERVE_CARD:
                 newGems = curGems + 1;
                 break;
             case BUY_CARD:
                 newGems = (curGems - board_.playerGems(pid).actualCost(
-                            mv.payload_.card_.cost_ - board_.playerPrestige(pid))).totalGems();
+                            mv.card().cost_ - board_.playerPrestige(pid))).totalGems();
                 break;
             }
 
@@ -223,7 +224,7 @@ TEST_F(LateGameBoard, preferWildcards)
 
         for (unsigned i = 0; i < moves.size(); ++i) {
             const auto mv = moves[i];
-            if (mv.type_ == MoveType::RESERVE_CARD && mv.payload_.card_.isWild()) {
+            if (mv.type() == MoveType::RESERVE_CARD && mv.card().isWild()) {
                 EXPECT_FLOAT_EQ(scores[i], 1);
             } else {
                 EXPECT_FLOAT_EQ(scores[i], 0);
@@ -242,7 +243,7 @@ TEST_F(LateGameBoard, countReturns)
 
     for (unsigned i = 0; i < moves.size(); ++i) {
         const auto mv = moves[i];
-        if (mv.type_ == MoveType::TAKE_GEMS && mv.payload_.gems_.hasNegatives()) {
+        if (mv.type() == MoveType::TAKE_GEMS && mv.gems().hasNegatives()) {
             EXPECT_FLOAT_EQ(scores[i], 1);
         } else {
             EXPECT_FLOAT_EQ(scores[i], 0);
@@ -303,4 +304,97 @@ TEST_F(LateGameBoard, cardDraw)
     const auto scores = playerScores(0, allEval2);
     const auto max_score = *std::max_element(std::begin(scores), std::end(scores));
     EXPECT_EQ(max_score, scoreOf(scores, moves, GameMove(g_deck[15], BUY_CARD)));
-}
\ No newline at end of file
+}
+
+// Combining the evaluation functions in Feature order scores moves in one batch,
+// which should match combining them one at a time (wrapped, so combine can't tell):
+TEST_F(LateGameBoard, featureEvaluator)
+{
+    const std::vector<evaluator_t> funcs = { winCondition, countPoints, countPrestige, countGems,
+        countMoves, monopolizeGems, preferWildcards, countReturns, preferShortGame, preferBuyTowardNoble };
+    const FeatureWeights weights = { 100, 1.5, 1, 1, 2.25, -0.25, 0, -1, 1, 2.5 };
+    std::vector<evaluator_t> wrapped;
+    for (const auto& f : funcs) {
+        wrapped.push_back([f](const Moves& moves, player_id_t pid, const Board& board,
+                              const std::vector<Board>& newBoards) {
+            return f(moves, pid, board, newBoards);
+        });
+    }
+    const std::vector<score_t> wvec(weights.begin(), weights.end());
+
+    BUY(1, g_deck[4], g_deck[18]);
+    TAKE(0, Gems({ 1, 1, 1, 0, 0 }));
+    const auto batched = playerScores(0, combine(funcs, wvec));
+    const auto generic = playerScores(0, combine(wrapped, wvec));
+    const auto direct = playerScores(0, featureEvaluator(weights));
+    ASSERT_EQ(generic.size(), batched.size());
+    ASSERT_EQ(generic.size(), direct.size());
+    for (unsigned i = 0; i < generic.size(); ++i) {
+        EXPECT_FLOAT_EQ(generic[i], batched[i]);
+        EXPECT_EQ(batched[i], direct[i]);
+    }
+}
+
+
+// A fused evaluator, with its terms in Feature order, should score exactly like combine():
+TEST_F(LateGameBoard, fusedEvaluator)
+{
+    const FusedEvaluator<Term<WINS, 100>, Term<POINT_GAIN, 3, 2>, Term<PRESTIGE_GAIN, 1>, Term<GEM_GAIN, 1>,
+                         Term<MOBILITY, 9, 4>, Term<RARITY, -1, 4>, Term<RETURNS, -1>, Term<GAME_LENGTH, 1>,
+                         Term<NOBLE_PROGRESS, 5, 2>> fused;
+    const auto combined = featureEvaluator({ 100, 1.5, 1, 1, 2.25, -0.25, 0, -1, 1, 2.5 });
+
+    BUY(1, g_deck[4], g_deck[18]);
+    TAKE(0, Gems({ 1, 1, 1, 0, 0 }));
+    RESERVE(0, g_deck[71], g_deck[15]);
+    const auto expected = playerScores(0, combined);
+    const auto actual = playerScores(0, fused);
+    ASSERT_EQ(expected.size(), actual.size());
+    for (unsigned i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i], actual[i]);
+    }
+
+    // A single term is the feature's evaluation function, weighed:
+    const auto points = playerScores(0, countPoints);
+    const auto triple = playerScores(0, FusedEvaluator<Term<POINT_GAIN, 3>>());
+    for (unsigned i = 0; i < points.size(); ++i) {
+        EXPECT_EQ(3 * points[i], triple[i]);
+    }
+}
+
+
+// The gains of the position evaluation functions are the scores of their move
+// evaluation functions:
+TEST_F(LateGameBoard, positionGain)
+{
+    BUY(1, g_deck[4], g_deck[18]);
+    TAKE(0, Gems({ 1, 1, 1, 0, 0 }));
+    RESERVE(0, g_deck[71], g_deck[15]);
+
+    const auto moves = legalMoves(board_, 0);
+    const std::vector<std::pair<evaluator_t, position_evaluator_t>> pairs = {
+        { countPoints, positionPoints }, { countPrestige, positionPrestige },
+        { countGems, positionGems }, { winCondition, positionWin }
+    };
+    for (const auto& p : pairs) {
+        const auto expected = playerScores(0, p.first);
+        const auto actual = playerScores(0, positionGain(p.second));
+        ASSERT_EQ(moves.size(), actual.size());
+        for (unsigned i = 0; i < moves.size(); ++i) {
+            EXPECT_DOUBLE_EQ(expected[i], actual[i]);
+        }
+    }
+
+    // Except for the moves that win a noble:
+    std::vector<Board> nb;
+    const auto toward = computeScores(preferBuyTowardNoble, moves, 0, board_, nb);
+    const auto gains = computeScores(positionGain(positionNobleProgress), moves, 0, board_, nb);
+    for (unsigned i = 0; i < moves.size(); ++i) {
+        if (nb[i].tableNobles().size() == board_.tableNobles().size()) {
+            EXPECT_DOUBLE_EQ(toward[i], gains[i]);
+        }
+    }
+
+    const auto combined = combinePositions({ positionPoints, positionGems }, { 2, -1 });
+    EXPECT_EQ(2 * positionPoints(board_, 1) - positionGems(board_, 1), combined(board_, 1));
+}
@@ -6,7 +6,12 @@
 #include "gtest/gtest.h"
 #include "gems.h"
 
+#include <algorithm>
+#include <array>
+#include <numeric>
+
 using namespace grandeur;
+using namespace std;
 
 TEST(gemsTest, ctorFromInitializerList)
 {
@@ -106,4 +111,142 @@ TEST_F(shortGems, detectNegative)
 
 TEST_F(shortGems, verifyMaxQuantity) {
     ASSERT_EQ(data_.getCount(data_.maxColor()), 3);
-}
\ No newline at end of file
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+// Gems operations are computed on all colors at once (SWAR). The following tests
+// compare them exhaustively to straightforward scalar versions, on plain arrays.
+
+using Counts = array<gem_count_t, NCOLOR>;
+
+static Gems toGems(const Counts& counts) { return Gems(counts.cbegin(), counts.cend()); }
+
+static Counts
+scalarAdd(Counts lhs, const Counts& rhs, int sign)
+{
+    for (unsigned i = 0; i < NCOLOR; ++i) {
+        lhs[i] = gem_count_t(lhs[i] + sign * rhs[i]);
+    }
+    return lhs;
+}
+
+static Counts
+scalarActualCost(const Counts& mine, const Counts& cost)
+{
+    Counts ret = {};
+    for (unsigned color = 0; color < NCOLOR - 1; ++color) {
+        const auto positiveCost = max(cost[color], gem_count_t(0));
+        ret[color] = min(mine[color], positiveCost);
+        ret[YELLOW] += max(0, positiveCost - mine[color]);
+    }
+    return ret;
+}
+
+// Check all the reductions of one collection of gems:
+static void
+checkReductions(const Counts& counts)
+{
+    const auto gems = toGems(counts);
+    ASSERT_EQ(accumulate(counts.cbegin(), counts.cend(), 0), gems.totalGems());
+    ASSERT_EQ(count_if(counts.cbegin(), counts.cend(), [](int c){ return c > 0; }), gems.positiveColors());
+    ASSERT_EQ(any_of(counts.cbegin(), counts.cend(), [](int c){ return c < 0; }), gems.hasNegatives());
+    ASSERT_EQ(distance(counts.cbegin(), max_element(counts.cbegin(), counts.cend())), gems.maxColor());
+}
+
+
+// Every pair of values, in every color (with other values in the other colors):
+TEST(gemsSwar, addSubAllValues)
+{
+    for (int a = -128; a < 128; ++a) {
+        for (int b = -128; b < 128; ++b) {
+            for (unsigned color = 0; color < NCOLOR; ++color) {
+                Counts x, y;
+                for (unsigned i = 0; i < NCOLOR; ++i) {
+                    x[i] = gem_count_t(a + 37 * i);
+                    y[i] = gem_count_t(b - 91 * i);
+                }
+                x[color] = a;
+                y[color] = b;
+
+                ASSERT_EQ(toGems(scalarAdd(x, y, 1)), toGems(x) + toGems(y)) << a << " + " << b;
+                ASSERT_EQ(toGems(scalarAdd(x, y, -1)), toGems(x) - toGems(y)) << a << " - " << b;
+            }
+        }
+    }
+}
+
+
+// Every value in every color, then every collection of typical game values:
+TEST(gemsSwar, reductions)
+{
+    for (int a = -128; a < 128; ++a) {
+        for (unsigned color = 0; color < NCOLOR; ++color) {
+            for (const gem_count_t others : { -128, -1, 0, 1, 127 }) {
+                Counts counts;
+                counts.fill(others);
+                counts[color] = a;
+                checkReductions(counts);
+            }
+        }
+    }
+
+    Counts counts;
+    for (unsigned i = 0; i < 12 * 12 * 12 * 12 * 12 * 12; ++i) {
+        for (unsigned color = 0, n = i; color < NCOLOR; ++color, n /= 12) {
+            counts[color] = int(n % 12) - 4;
+        }
+        checkReductions(counts);
+    }
+}
+
+
+// Every (owned, cost) pair in every color, then every collection of small values:
+TEST(gemsSwar, actualCost)
+{
+    for (int mine = 0; mine < 128; ++mine) {
+        for (int cost = -128; cost < 128; ++cost) {
+            for (unsigned color = 0; color < NCOLOR - 1; ++color) {
+                Counts x = { 1, 2, 0, 3, 0, 2 }, y = { 2, -1, 1, 0, 3, 0 };
+                x[color] = mine;
+                y[color] = cost;
+                ASSERT_EQ(toGems(scalarActualCost(x, y)), toGems(x).actualCost(toGems(y)))
+                        << mine << " for " << cost;
+            }
+        }
+    }
+
+    Counts x, y;
+    for (unsigned i = 0; i < 3 * 3 * 3 * 3 * 3 * 3; ++i) {
+        for (unsigned color = 0, n = i; color < NCOLOR; ++color, n /= 3) {
+            x[color] = n % 3;
+        }
+        for (unsigned j = 0; j < 5 * 5 * 5 * 5 * 5; ++j) {
+            for (unsigned color = 0, n = j; color < NCOLOR - 1; ++color, n /= 5) {
+                y[color] = int(n % 5) - 1;
+            }
+            y[YELLOW] = 0;
+            ASSERT_EQ(toGems(scalarActualCost(x, y)), toGems(x).actualCost(toGems(y)));
+        }
+    }
+}
+
+
+// canPay agrees with paying the actual cost, for every collection of small values:
+TEST(gemsSwar, canPay)
+{
+    Counts x, y;
+    for (unsigned i = 0; i < 4 * 4 * 4 * 4 * 4 * 4; ++i) {
+        for (unsigned color = 0, n = i; color < NCOLOR; ++color, n /= 4) {
+            x[color] = n % 4;
+        }
+        for (unsigned j = 0; j < 6 * 6 * 6 * 6 * 6; ++j) {
+            for (unsigned color = 0, n = j; color < NCOLOR - 1; ++color, n /= 6) {
+                y[color] = n % 6;
+            }
+            y[YELLOW] = 0;
+            const auto mine = toGems(x), cost = toGems(y);
+            ASSERT_EQ(!(mine - mine.actualCost(cost)).hasNegatives(), mine.canPay(cost)) << mine << " for " << cost;
+        }
+    }
+}
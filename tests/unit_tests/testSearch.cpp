@@ -0,0 +1,602 @@
+// Test that the different search players agree with each other, and behave consistently
+//
+
+#include "gtest/gtest.h"
+
+#include "board.h"
+#include "eval.h"
+#include "game_context.h"
+#include "maxn_player.h"
+#include "mcts_player.h"
+#include "minimax_player.h"
+#include "move.h"
+#include "noble.h"
+#include "search_stats.h"
+#include "transposition_table.h"
+
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_init.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace grandeur;
+using namespace std;
+
+static const auto allEval =
+        combine({ winCondition, countPoints, countPrestige, countGems, countMoves,
+                  monopolizeGems, preferWildcards, countReturns, preferShortGame, preferBuyTowardNoble },
+                { 100, 2, 1, 1, 0, 0, 0, -1, 1, 2 });
+
+
+// A collection of two-player boards from different stages of randomly-played games:
+class RandomGameBoards : public ::testing::Test {
+  public:
+    RandomGameBoards();
+
+    static constexpr unsigned nplayer_ = 2;
+    vector<Board> boards_;
+};
+
+
+RandomGameBoards::RandomGameBoards()
+{
+    for (unsigned seed = 1; seed <= 4; ++seed) {
+        mt19937_64 prng(seed);
+        Deck deck(prng);
+
+        Cards initial;
+        for (int dt = LOW; dt <= HIGH; ++dt) {
+            for (unsigned i = 0; i < INITIAL_DECK_NCARD; ++i) {
+                initial.push_back(deck.draw(deck_t(dt)));
+            }
+        }
+        Board board(nplayer_, initial, { g_nobles[0], g_nobles[4], g_nobles[9] });
+
+        // Record the board early on, and then every few moves:
+        for (unsigned mv = 0; mv < 32 && !board.gameOver(); ++mv) {
+            const player_id_t pid = mv % nplayer_;
+            if (pid == 0) {
+                board.newRound();
+            }
+            const auto legal = legalMoves(board, pid);
+            if (legal.empty()) {
+                continue;
+            }
+            uniform_int_distribution<> dist(0, legal.size() - 1);
+            EXPECT_EQ(LEGAL_MOVE, makeMove(board, pid, legal[dist(prng)], NULL_CARD));
+            if (mv == 3 || mv % 8 == 7) {
+                boards_.push_back(board);
+            }
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+TEST(transpositionTable, storeAndProbe)
+{
+    TranspositionTable tt(4);
+    TranspositionTable::Entry entry;
+    EXPECT_EQ(tt.size(), 16);
+    EXPECT_FALSE(tt.probe(0x1234, entry));
+    EXPECT_EQ(tt.bytes(), 0);  // Not allocated until the first store
+
+    tt.store(0x1234, { -1.5, 3, TranspositionTable::LOWER, 7 });
+    EXPECT_GE(tt.bytes(), 16 * 3 * sizeof(uint64_t));
+    ASSERT_TRUE(tt.probe(0x1234, entry));
+    EXPECT_EQ(entry.score_, -1.5);
+    EXPECT_EQ(entry.depth_, 3);
+    EXPECT_EQ(entry.bound_, TranspositionTable::LOWER);
+    EXPECT_EQ(entry.bestMove_, 7);
+
+    // Same slot, different key:
+    EXPECT_FALSE(tt.probe(0x1234 + 16, entry));
+    tt.store(0x1234 + 16, { 2, 1, TranspositionTable::EXACT, TranspositionTable::NO_MOVE });
+    EXPECT_FALSE(tt.probe(0x1234, entry));
+    EXPECT_EQ(tt.probes(), 4);
+    EXPECT_EQ(tt.hits(), 1);
+
+    tt.clear();
+    EXPECT_FALSE(tt.probe(0x1234 + 16, entry));
+
+    // A table of size zero never holds anything:
+    TranspositionTable none(0);
+    none.store(0x1234, { 2, 1, TranspositionTable::EXACT, 0 });
+    EXPECT_FALSE(none.probe(0x1234, entry));
+    EXPECT_EQ(none.bytes(), 0);
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+// Neither alpha-beta pruning nor the transposition tables may change the chosen
+// move, only the effort to find it:
+TEST_F(RandomGameBoards, alphaBetaMatchesMinimax)
+{
+    for (unsigned depth = 1; depth <= 3; ++depth) {
+        for (const auto& board : boards_) {
+            for (player_id_t pid = 0; pid < nplayer_; ++pid) {
+                const auto legal = legalMoves(board, pid);
+                if (legal.empty()) {
+                    continue;
+                }
+                const MinimaxPlayer plain(depth, allEval, pid, 0.01, 0);
+                const MinimaxPlayer minimax(depth, allEval, pid, 0.01);
+                const AlphaBetaPlayer alphabeta(depth, allEval, pid, 0.01);
+                GameContext context(depth);
+                const auto expected = plain.getMove(board, legal, context);
+
+                EXPECT_EQ(expected, minimax.getMove(board, legal, context));
+                EXPECT_EQ(expected, alphabeta.getMove(board, legal, context));
+                EXPECT_LE(minimax.nodesVisited(), plain.nodesVisited());
+                EXPECT_LE(alphabeta.nodesVisited(), plain.nodesVisited());
+                if (depth == 1) {  // Nothing to reuse, so no table either
+                    EXPECT_EQ(0, minimax.transpositions().bytes());
+                    EXPECT_EQ(0, alphabeta.transpositions().bytes());
+                }
+            }
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+// Searching the siblings of deep nodes in parallel tasks (Young Brothers Wait)
+// changes how much gets pruned, but not the move picked, however the tasks
+// interleave. Several threads split the nodes, even on one core:
+TEST_F(RandomGameBoards, parallelAlphaBeta)
+{
+    tbb::task_scheduler_init init(4);
+    tbb::task_arena arena(4);
+    uint64_t serialTasks = 0, parallelTasks = 0;
+    for (unsigned depth = 3; depth <= 4; ++depth) {
+        for (const auto& board : boards_) {
+            const auto legal = legalMoves(board, 0);
+            if (legal.empty()) {
+                continue;
+            }
+            const MinimaxPlayer minimax(depth, allEval, 0, 0.01);
+            const AlphaBetaPlayer serial(depth, allEval, 0, 0.01), parallel(depth, allEval, 0, 0.01);
+            GameContext context(depth);
+            const auto expected = minimax.getMove(board, legal, context);
+
+            tbb::task_arena(1).execute([&] {
+                EXPECT_EQ(expected, serial.getMove(board, legal, context));
+            });
+            arena.execute([&] {
+                EXPECT_EQ(expected, parallel.getMove(board, legal, context));
+            });
+            serialTasks += serial.moveStats()->tasks_;
+            parallelTasks += parallel.moveStats()->tasks_;
+        }
+    }
+    EXPECT_LT(serialTasks, parallelTasks);
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+// Given enough time, iterative deepening reaches the maximum depth, and picks the
+// same move as a fixed-depth search. Given too little time, it stops early:
+TEST_F(RandomGameBoards, iterativeDeepening)
+{
+    for (const auto& board : boards_) {
+        const auto legal = legalMoves(board, 0);
+        if (legal.empty()) {
+            continue;
+        }
+        GameContext context(0), roomy(0, 600000);
+        const AlphaBetaPlayer fixed(3, allEval, 0, 0.01);
+        const AlphaBetaPlayer deepening(3, allEval, 0, 0.01, DEFAULT_TT_SIZE_LOG2, 1);
+        EXPECT_EQ(fixed.getMove(board, legal, context), deepening.getMove(board, legal, roomy));
+        EXPECT_EQ(3, deepening.depthReached());
+
+        const AlphaBetaPlayer hurried(100, allEval, 0, 0.01, DEFAULT_TT_SIZE_LOG2, 1);
+        const auto move = hurried.getMove(board, legal, context);
+        EXPECT_NE(legal.cend(), find(legal.cbegin(), legal.cend(), move));
+        EXPECT_GE(hurried.depthReached(), 1);
+        EXPECT_LT(hurried.depthReached(), 100);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////
+// A player's statistics cover only its last move, and add up to its totals:
+TEST_F(RandomGameBoards, searchStats)
+{
+    const AlphaBetaPlayer alphabeta(3, allEval, 0, 0.01);
+    const MinimaxPlayer minimax(2, allEval, 0, 0.01);
+    for (const Player* player : { static_cast<const Player*>(&alphabeta), static_cast<const Player*>(&minimax) }) {
+        uint64_t nodes = 0;
+        for (const auto& board : boards_) {
+            const auto legal = legalMoves(board, 0);
+            if (legal.empty()) {
+                continue;
+            }
+            GameContext context(0);
+            player->getMove(board, legal, context);
+            ASSERT_NE(nullptr, player->moveStats());
+            const auto stats = *player->moveStats();
+            EXPECT_EQ(1, stats.moves_);
+            EXPECT_GE(stats.nodes_, 1);
+            EXPECT_GE(stats.movesScored_, stats.nodes_);
+            EXPECT_GE(stats.boardCopies_, stats.movesScored_);
+            EXPECT_GE(stats.legalMovesCalls_ + 1, stats.nodes_);
+            nodes += stats.nodes_;
+        }
+        EXPECT_EQ(player == &alphabeta? alphabeta.nodesVisited() : minimax.nodesVisited(), nodes);
+    }
+    EXPECT_EQ(3, alphabeta.moveStats()->depth_);
+    EXPECT_EQ(2, minimax.moveStats()->depth_);
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+// The value of a board for pid, by plain minimax over position values. Past the
+// depth, it searches only buys, and reserving a card with points that the opponent
+// could buy, for up to `plies` turns. The game only ends after player 1's turn,
+// and a player without moves passes:
+static score_t
+minimaxValue(const position_evaluator_t& eval, player_id_t pid, unsigned depth, const Board& board,
+             unsigned plies)
+{
+    const auto leaf = eval(board, pid) - eval(board, 1 - pid);
+    const auto legal = legalMoves(board, pid);
+    if ((depth == 0 && plies == 0) || (pid == 0 && board.gameOver())) {
+        return leaf;
+    }
+    if (depth > 0 && legal.empty()) {
+        Board next = board;
+        if (pid == 0) {
+            next.newRound();
+        }
+        return -minimaxValue(eval, 1 - pid, depth - 1, next, plies);
+    }
+
+    const auto threat = [&](const GameMove& mv) {
+        Board opponentBuys = board;
+        return mv.type() == RESERVE_CARD && !mv.card().isWild() && mv.card().points_ > 0
+            && opponentBuys.buyCard(1 - pid, mv.card().id_, NULL_CARD) == LEGAL_MOVE;
+    };
+
+    auto best = (depth == 0)? leaf : -numeric_limits<score_t>::infinity();
+    for (const auto& mv : legal) {
+        if (depth == 0 && mv.type() != BUY_CARD && !threat(mv)) {
+            continue;
+        }
+        Board child = board;
+        child.apply(pid, mv);
+        if (pid == 0) {
+            child.newRound();
+        }
+        best = max(best, (depth > 0)? -minimaxValue(eval, 1 - pid, depth - 1, child, plies)
+                                    : -minimaxValue(eval, 1 - pid, 0, child, plies - 1));
+    }
+    return best;
+}
+
+
+// Negamax's pruning and transposition table may not change the value of its move,
+// with or without a quiescence search:
+TEST_F(RandomGameBoards, negamaxMatchesMinimax)
+{
+    const auto positionEval =
+            combinePositions({ positionWin, positionPoints, positionPrestige, positionGems, positionNobleProgress },
+                             { 100, 2, 1, 1, 2 });
+
+    for (unsigned depth = 1; depth <= 3; ++depth) {
+        for (const auto& board : boards_) {
+            for (player_id_t pid = 0; pid < nplayer_; ++pid) {
+                const auto legal = legalMoves(board, pid);
+                if (legal.empty()) {
+                    continue;
+                }
+                for (const auto plies : { 0u, 3u }) {
+                    const auto expected = minimaxValue(positionEval, pid, depth, board, plies);
+                    for (const auto ttSizeLog2 : { 0u, DEFAULT_TT_SIZE_LOG2 }) {
+                        const NegamaxPlayer negamax(depth, positionEval, pid, ttSizeLog2, plies);
+                        GameContext context(depth);
+                        Board child = board;
+                        child.apply(pid, negamax.getMove(board, legal, context));
+                        if (pid == 0) {
+                            child.newRound();
+                        }
+                        EXPECT_DOUBLE_EQ(expected, -minimaxValue(positionEval, 1 - pid, depth - 1, child, plies));
+                        EXPECT_GT(negamax.nodesVisited(), legal.size());
+                        EXPECT_EQ(negamax.nodesVisited(), negamax.moveStats()->nodes_);
+                        EXPECT_EQ(depth, negamax.moveStats()->depth_);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+// Given as many chance samples as there are cards, expectimax averages a move
+// that draws a card over every card that could still be undealt. At depth 2,
+// each of these is worth the move's score minus the opponent's best reply:
+TEST_F(RandomGameBoards, expectimaxAveragesReplacements)
+{
+    const auto bestReply = [](player_id_t pid, const Board& board) {
+        const auto opMoves = legalMoves(board, 1 - pid);
+        if (opMoves.empty()) {
+            return 0.;
+        }
+        const auto scores = 0.01 * computeScores(allEval, opMoves, 1 - pid, board);
+        return *max_element(scores.cbegin(), scores.cend());
+    };
+    const auto reply = [&](player_id_t pid, const Board& board, const GameMove& mv, const Card& replacement) {
+        Board child = board;
+        child.apply(pid, mv, replacement);
+        if (pid == 0) {
+            child.newRound();
+        }
+        return bestReply(pid, child);
+    };
+
+    unsigned chanceMoves = 0;
+    for (const auto& board : boards_) {
+        for (player_id_t pid = 0; pid < nplayer_; ++pid) {
+            const auto legal = legalMoves(board, pid);
+            if (legal.empty()) {
+                continue;
+            }
+
+            auto expected = 2 * 0.01 * computeScores(allEval, legal, pid, board);
+            for (unsigned i = 0; i < legal.size(); ++i) {
+                const auto& mv = legal[i];
+                const auto dt = (mv.type() == TAKE_GEMS)? LOW : mv.card().id_.type_;
+                if (mv.type() == TAKE_GEMS || !(mv.card().isWild() || board.isOnTable(mv.card()))
+                 || !board.remainingCards(dt)) {
+                    expected[i] -= reply(pid, board, mv, NULL_CARD);
+                    continue;
+                }
+
+                ++chanceMoves;
+                const auto undealt = board.undealtCards(dt);
+                score_t sum = 0;
+                for (unsigned idx = 0; idx < NCARDS; ++idx) {
+                    if (undealt[idx]) {
+                        sum += mv.card().isWild()? reply(pid, board, GameMove(g_deck[idx], RESERVE_CARD), NULL_CARD)
+                                                 : reply(pid, board, mv, g_deck[idx]);
+                    }
+                }
+                expected[i] -= sum / undealt.count();
+            }
+
+            const MinimaxPlayer expectimax(2, allEval, pid, 0.01, DEFAULT_TT_SIZE_LOG2, NCARDS);
+            GameContext context(pid);
+            const auto chosen = find(legal.cbegin(), legal.cend(), expectimax.getMove(board, legal, context));
+            EXPECT_DOUBLE_EQ(*max_element(expected.cbegin(), expected.cend()),
+                             expected[distance(legal.cbegin(), chosen)]);
+
+            // A few samples per chance node are drawn the same way every time:
+            const MinimaxPlayer sampled1(3, allEval, pid, 0.01, DEFAULT_TT_SIZE_LOG2, 2);
+            const MinimaxPlayer sampled2(3, allEval, pid, 0.01, DEFAULT_TT_SIZE_LOG2, 2);
+            EXPECT_EQ(sampled1.getMove(board, legal, context), sampled2.getMove(board, legal, context));
+        }
+    }
+    EXPECT_GT(chanceMoves, 0);
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+// Plain max^n: every player's share of the players' values at the leaves, where
+// each player picks the first of its best moves. And plain paranoid minimax, where
+// the leaves are worth root's value minus the best of the others'. The game only
+// ends after the last player's turn, and a player without moves passes:
+static vector<score_t>
+maxnValues(const position_evaluator_t& eval, player_id_t pid, unsigned depth, const Board& board)
+{
+    const auto legal = legalMoves(board, pid);
+    if (depth == 0 || (pid == 0 && board.gameOver())) {
+        vector<score_t> values;
+        for (player_id_t p = 0; p < board.playersNum(); ++p) {
+            values.push_back(eval(board, p));
+        }
+        const auto total = accumulate(values.cbegin(), values.cend(), 0.);
+        for (auto& value : values) {
+            value = (total > 0)? value / total : 1. / board.playersNum();
+        }
+        return values;
+    }
+    if (legal.empty()) {
+        Board next = board;
+        if (pid + 1 == board.playersNum()) {
+            next.newRound();
+        }
+        return maxnValues(eval, (pid + 1) % board.playersNum(), depth - 1, next);
+    }
+
+    vector<score_t> best;
+    for (const auto& mv : legal) {
+        Board child = board;
+        child.apply(pid, mv);
+        if (pid + 1 == board.playersNum()) {
+            child.newRound();
+        }
+        const auto values = maxnValues(eval, (pid + 1) % board.playersNum(), depth - 1, child);
+        if (best.empty() || values[pid] > best[pid]) {
+            best = values;
+        }
+    }
+    return best;
+}
+
+static score_t
+paranoidValue(const position_evaluator_t& eval, player_id_t root, player_id_t pid, unsigned depth,
+              const Board& board)
+{
+    const auto legal = legalMoves(board, pid);
+    if (depth == 0 || (pid == 0 && board.gameOver())) {
+        auto others = -numeric_limits<score_t>::infinity();
+        for (player_id_t p = 0; p < board.playersNum(); ++p) {
+            if (p != root) {
+                others = max(others, eval(board, p));
+            }
+        }
+        return eval(board, root) - others;
+    }
+    if (legal.empty()) {
+        Board next = board;
+        if (pid + 1 == board.playersNum()) {
+            next.newRound();
+        }
+        return paranoidValue(eval, root, (pid + 1) % board.playersNum(), depth - 1, next);
+    }
+
+    Scores values;
+    for (const auto& mv : legal) {
+        Board child = board;
+        child.apply(pid, mv);
+        if (pid + 1 == board.playersNum()) {
+            child.newRound();
+        }
+        values.push_back(paranoidValue(eval, root, (pid + 1) % board.playersNum(), depth - 1, child));
+    }
+    return (pid == root)? *max_element(values.cbegin(), values.cend())
+                        : *min_element(values.cbegin(), values.cend());
+}
+
+
+// With 3 and 4 players, shallow pruning doesn't change the max^n move, nor does
+// alpha-beta pruning change the paranoid move:
+TEST(maxn, matchesPlainSearch)
+{
+    const auto positionEval =
+            combinePositions({ positionWin, positionPoints, positionPrestige, positionGems, positionNobleProgress },
+                             { 100, 2, 1, 1, 2 });
+
+    for (unsigned nplayer = 3; nplayer <= MAX_NPLAYER; ++nplayer) {
+        mt19937_64 prng(nplayer);
+        Deck deck(prng);
+        Cards initial;
+        for (int dt = LOW; dt <= HIGH; ++dt) {
+            for (unsigned i = 0; i < INITIAL_DECK_NCARD; ++i) {
+                initial.push_back(deck.draw(deck_t(dt)));
+            }
+        }
+        Board board(nplayer, initial, Board::Nobles(begin(g_nobles), begin(g_nobles) + nplayer + 1));
+
+        // Search a board early in the game, and one after a few random rounds:
+        for (unsigned mv = 0; mv <= 4 * nplayer; ++mv) {
+            const player_id_t pid = mv % nplayer;
+            if (pid == 0) {
+                board.newRound();
+            }
+            const auto legal = legalMoves(board, pid);
+            if (legal.empty()) {
+                continue;
+            }
+
+            if (mv == 1 || mv == 4 * nplayer - 1) {
+                for (unsigned depth = 1; depth <= 5 - nplayer / 2; ++depth) {
+                    vector<score_t> maxn, paranoid;
+                    for (const auto& legalMove : legal) {
+                        Board child = board;
+                        child.apply(pid, legalMove);
+                        if (pid + 1 == nplayer) {
+                            child.newRound();
+                        }
+                        const auto next = (pid + 1) % nplayer;
+                        maxn.push_back(maxnValues(positionEval, next, depth - 1, child)[pid]);
+                        paranoid.push_back(paranoidValue(positionEval, pid, next, depth - 1, child));
+                    }
+
+                    const MaxnPlayer maxnPlayer(MaxnPlayer::MAXN, depth, positionEval, pid);
+                    const MaxnPlayer paranoidPlayer(MaxnPlayer::PARANOID, depth, positionEval, pid);
+                    GameContext context(depth);
+                    EXPECT_EQ(legal[distance(maxn.cbegin(), max_element(maxn.cbegin(), maxn.cend()))],
+                              maxnPlayer.getMove(board, legal, context));
+                    EXPECT_EQ(legal[distance(paranoid.cbegin(), max_element(paranoid.cbegin(), paranoid.cend()))],
+                              paranoidPlayer.getMove(board, legal, context));
+                    EXPECT_GT(maxnPlayer.nodesVisited(), legal.size());
+                }
+            }
+
+            uniform_int_distribution<> dist(0, legal.size() - 1);
+            EXPECT_EQ(LEGAL_MOVE, makeMove(board, pid, legal[dist(prng)], NULL_CARD));
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+// MCTS works for any no. of players, uses up exactly its budget of iterations
+// in every tree, and picks the same move given the same game seed:
+TEST(mcts, reproducibleForAnyPlayers)
+{
+    for (unsigned nplayer = 2; nplayer <= MAX_NPLAYER; ++nplayer) {
+        Deck deck(Cards(begin(g_deck), end(g_deck)));
+        Cards initial;
+        for (int dt = LOW; dt <= HIGH; ++dt) {
+            for (unsigned i = 0; i < INITIAL_DECK_NCARD; ++i) {
+                initial.push_back(deck.draw(deck_t(dt)));
+            }
+        }
+        Board::Nobles nobles(begin(g_nobles), begin(g_nobles) + nplayer + 1);
+        Board board(nplayer, initial, nobles);
+        board.newRound();
+
+        const auto legal = legalMoves(board, 0);
+        for (const auto rollout : { MctsPlayer::RANDOM_ROLLOUT, MctsPlayer::GREEDY_ROLLOUT }) {
+            const MctsPlayer first(30, 0, rollout, allEval, 0, 3);
+            const MctsPlayer second(30, 0, rollout, allEval, 0, 3);
+            GameContext context1(nplayer), context2(nplayer);
+            const auto move = first.getMove(board, legal, context1);
+
+            EXPECT_NE(legal.cend(), find(legal.cbegin(), legal.cend(), move));
+            EXPECT_EQ(move, second.getMove(board, legal, context2));
+            EXPECT_EQ(3 * 30, first.iterations());
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+// The iteration budget is per tree: more trees add iterations instead of
+// splitting them. A search's move depends on its no. of trees, but not on how
+// many threads grow them, and the registered levels always grow four trees:
+TEST(mcts, budgetPerTree)
+{
+    tbb::task_scheduler_init init(4);
+    Deck deck(Cards(begin(g_deck), end(g_deck)));
+    Cards initial;
+    for (int dt = LOW; dt <= HIGH; ++dt) {
+        for (unsigned i = 0; i < INITIAL_DECK_NCARD; ++i) {
+            initial.push_back(deck.draw(deck_t(dt)));
+        }
+    }
+    Board board(3, initial, { g_nobles[0], g_nobles[4], g_nobles[9], g_nobles[7] });
+    board.newRound();
+    const auto legal = legalMoves(board, 0);
+
+    for (const auto nthread : { 1, 4 }) {
+        tbb::task_arena arena(nthread);
+        const MctsPlayer one(40, 0, MctsPlayer::RANDOM_ROLLOUT, allEval, 0, 1);
+        const MctsPlayer four(40, 0, MctsPlayer::RANDOM_ROLLOUT, allEval, 0, 4);
+        const MctsPlayer serialFour(40, 0, MctsPlayer::RANDOM_ROLLOUT, allEval, 0, 4);
+        GameContext context1(5), context4(5), serialContext(5);
+        GameMove move, serialMove;
+        arena.execute([&] {
+            one.getMove(board, legal, context1);
+            move = four.getMove(board, legal, context4);
+        });
+        tbb::task_arena(1).execute([&] { serialMove = serialFour.getMove(board, legal, serialContext); });
+
+        EXPECT_EQ(40, one.iterations());
+        EXPECT_EQ(4 * 40, four.iterations());
+        EXPECT_EQ(serialMove, move);
+        EXPECT_EQ(4 * 40, four.moveStats()->nodes_);
+        EXPECT_EQ(4, four.moveStats()->tasks_);
+
+        const unique_ptr<const Player> level(PlayerFactory::instance().create("mcts-1", 0));
+        GameContext levelContext(5);
+        arena.execute([&] { level->getMove(board, legal, levelContext); });
+        EXPECT_EQ(4 * 250, dynamic_cast<const MctsPlayer&>(*level).iterations());
+    }
+}
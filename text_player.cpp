@@ -18,7 +18,14 @@ namespace grandeur {
 TextPlayer::TextPlayer(player_id_t pid)
    : Player(pid), os_(cout)
 {
-    MoveNotifier::instance().registerObserver(
+}
+
+
+/////////////////////////////////////////////////////////////
+void
+TextPlayer::subscribe(MoveNotifier& notifier) const
+{
+    notifier.registerObserver(
             [=](MoveEvent event, const Board& board, player_id_t pid,
                 const MoveNotifier::Payload& payload)
             {
@@ -29,7 +36,7 @@ TextPlayer::TextPlayer(player_id_t pid)
 
 /////////////////////////////////////////////////////////////
 GameMove
-TextPlayer::getMove(const Board& board, const Moves& legal) const
+TextPlayer::getMove(const Board& board, const Moves& legal, GameContext&) const
 {
 
     if (legal.empty()) {
@@ -72,7 +79,7 @@ TextPlayer::getMove(const Board& board, const Moves& legal) const
 /////////////////////////////////////////////////////////////
 void
 TextPlayer::moveUpdater(MoveEvent event, const Board& board, player_id_t pid,
-                        const MoveNotifier::Payload& payload)
+                        const MoveNotifier::Payload& payload) const
 {
     switch(event) {
     case MoveEvent::GAME_BEGAN:
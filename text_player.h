@@ -16,10 +16,11 @@ namespace grandeur {
 class TextPlayer final : public Player {
   public:
     TextPlayer(player_id_t pid);
-    virtual GameMove getMove(const Board& board, const Moves& legal) const;
+    virtual GameMove getMove(const Board& board, const Moves& legal, GameContext& context) const;
+    virtual void subscribe(MoveNotifier& notifier) const;
 
     void moveUpdater(MoveEvent event, const Board& board, player_id_t pid,
-                         const MoveNotifier::Payload& payload);
+                     const MoveNotifier::Payload& payload) const;
 
     std::ostream& os_;
 };
@@ -0,0 +1,258 @@
+//
+// Tournament implementation. Games run on a TBB parallel_for, and game statistics
+// are collected by an observer of each game's MoveNotifier.
+//
+
+#include "tournament.h"
+
+#include "board.h"
+#include "game_context.h"
+#include "move_notifier.h"
+
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+
+using namespace std;
+
+namespace grandeur {
+
+/////////////////////////////////////////////////////////////
+static void
+collectStats(Tournament::GameStats* stats, MoveEvent event, const Board& board, player_id_t pid,
+             const MoveNotifier::Payload& payload)
+{
+    switch (event) {
+    case MoveEvent::MOVE_TAKEN:
+        if (pid != 0) {
+            break;
+        }
+        switch (payload.mv_.type()) {
+        case TAKE_GEMS:
+            if (payload.mv_.gems().positiveColors() == 1) {
+                ++stats->take2_;
+            } else {
+                ++stats->take3_;
+            }
+            break;
+        case BUY_CARD:
+            ++stats->buy_;
+            ++stats->buyDeck_[payload.mv_.card().id_.type_];
+            break;
+        case RESERVE_CARD:
+            ++stats->reserve_;
+            break;
+        }
+        break;
+
+    case MoveEvent::NOBLE_WON:
+        ++stats->nobles_[pid];
+        break;
+
+    case MoveEvent::MOVE_STATS:
+        stats->search_[pid] += *payload.stats_;
+        break;
+
+    case MoveEvent::GAME_WON:
+    case MoveEvent::TIE:
+        stats->winner_ = pid;
+        stats->rounds_ = board.roundNumber();
+        for (player_id_t p = 0; p < board.playersNum(); ++p) {
+            stats->points_[p] = board.playerPoints(p);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+/////////////////////////////////////////////////////////////
+// The minimax level is the number at the end of player 0's name (e.g. minimax-3):
+static unsigned
+playerLevel(const string& name)
+{
+    const auto digits = name.find_last_not_of("0123456789");
+    return (digits + 1 < name.size())? stoul(name.substr(digits + 1)) : 0;
+}
+
+
+/////////////////////////////////////////////////////////////
+static void
+writeHeader(ostream& csv)
+{
+    csv << "Minimax_level,games,loss_rate,rounds_per_game,take2_rate,take3_rate,buy_rate,"
+        << "reserve_rate,point_diff,nobles_0,nobles_1,buy_low_rate,buy_med_rate,buy_high_rate\n";
+}
+
+
+/////////////////////////////////////////////////////////////
+static void
+writeGame(ostream& csv, unsigned level, unsigned nplayer, const Tournament::GameStats& stats)
+{
+    const auto moves = max(1u, stats.take2_ + stats.take3_ + stats.buy_ + stats.reserve_);
+    const auto buys = max(1u, stats.buy_);
+    const bool lost = stats.winner_ != 0 && stats.winner_ < nplayer;
+
+    csv << level << ",1," << lost << "," << stats.rounds_
+        << fixed << setprecision(4)
+        << "," << double(stats.take2_) / moves
+        << "," << double(stats.take3_) / moves
+        << "," << double(stats.buy_) / moves
+        << "," << double(stats.reserve_) / moves
+        << "," << int(stats.points_[0]) - int(stats.points_[1])
+        << "," << stats.nobles_[0] << "," << stats.nobles_[1]
+        << "," << double(stats.buyDeck_[LOW]) / buys
+        << "," << double(stats.buyDeck_[MEDIUM]) / buys
+        << "," << double(stats.buyDeck_[HIGH]) / buys
+        << endl;
+}
+
+
+/////////////////////////////////////////////////////////////
+Tournament::Tournament(const Config& config)
+  : config_(config), results_(config.ngames_)
+{
+}
+
+
+/////////////////////////////////////////////////////////////
+void
+Tournament::run(ostream* csv)
+{
+    mutex csvMutex;
+    const auto level = playerLevel(config_.playerNames_.at(0));
+    if (csv) {
+        writeHeader(*csv);
+    }
+
+    const auto start = chrono::steady_clock::now();
+    tbb::parallel_for(0u, unsigned(results_.size()), [&](unsigned game)
+    {
+        results_[game] = play(config_.seed_ + game);
+        if (csv) {
+            lock_guard<mutex> lock(csvMutex);
+            writeGame(*csv, level, config_.playerNames_.size(), results_[game]);
+        }
+    });
+    seconds_ = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+/////////////////////////////////////////////////////////////
+// Set up the game exactly like a single game with the same seed:
+Tournament::GameStats
+Tournament::play(uint64_t seed) const
+{
+    GameStats stats;
+    const auto start = chrono::steady_clock::now();
+
+    GameContext context(seed, config_.moveMillis_, config_.stats_);
+    context.alone_ = (config_.nthread_ == 1 || results_.size() == 1);
+    Deck deck(context.prng_);
+    auto board = config_.createBoard(deck, context.prng_);
+
+    Players players;
+    for (const auto& name : config_.playerNames_) {
+        players.push_back(PlayerFactory::instance().create(name, players.size()));
+        assert(players.back());
+    }
+
+    MoveNotifier notifier;
+    notifier.registerObserver([&stats](MoveEvent event, const Board& board, player_id_t pid,
+                                       const MoveNotifier::Payload& payload)
+                              { collectStats(&stats, event, board, pid, payload); });
+    mainGameLoop(board, deck, players, notifier, context);
+
+    for (auto p : players) {
+        delete p;
+    }
+
+    stats.seconds_ = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+
+/////////////////////////////////////////////////////////////
+// Each player's score is its no. of wins, plus an equal share of each tie.
+// The Elo estimate is the rating difference from an average opponent that
+// would predict this score: a share s of the points among n players means
+// odds of (n-1)s/(1-s) against each of the others.
+void
+Tournament::report(ostream& os) const
+{
+    const auto nplayer = config_.playerNames_.size();
+    const auto ngames = results_.size();
+    vector<unsigned> wins(nplayer, 0);
+    unsigned ties = 0;
+    double gameSeconds = 0;
+    for (const auto& stats : results_) {
+        if (stats.winner_ < nplayer) {
+            ++wins[stats.winner_];
+        } else {
+            ++ties;
+        }
+        gameSeconds += stats.seconds_;
+    }
+
+    os << "Played " << ngames << " games in " << fixed << setprecision(2) << seconds_ << " seconds ("
+       << setprecision(1) << ngames / seconds_ << " games/sec, "
+       << setprecision(2) << 1000 * gameSeconds / ngames << " ms per game)\n";
+    os << "Player                 Wins  Losses    Ties   Score      Elo\n";
+
+    for (player_id_t pid = 0; pid < nplayer; ++pid) {
+        const auto score = (wins[pid] + double(ties) / nplayer) / ngames;
+        const auto s = min(max(score, 0.5 / ngames), 1 - 0.5 / ngames);
+        const auto elo = 400 * log10((nplayer - 1) * s / (1 - s));
+        os << pid << ": " << left << setw(16) << config_.playerNames_[pid] << right
+           << setw(8) << wins[pid] << setw(8) << ngames - wins[pid] - ties << setw(8) << ties
+           << setw(8) << setprecision(3) << score << setw(9) << setprecision(0) << elo << "\n";
+    }
+
+    if (config_.stats_) {
+        reportSearch(os);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////
+// Games run concurrently, so per-move times include the time that the players'
+// threads spent on other games. The node rates are therefore per player, in the
+// tournament's conditions, rather than what a player would achieve alone.
+void
+Tournament::reportSearch(ostream& os) const
+{
+    const auto nplayer = config_.playerNames_.size();
+    os << "\nPlayer                Moves  Depth   Nodes/move    Nodes/sec  Branching"
+       << "  Eval ms/move  Tasks/move  ms/move\n";
+    for (player_id_t pid = 0; pid < nplayer; ++pid) {
+        SearchStats total;
+        for (const auto& stats : results_) {
+            total += stats.search_[pid];
+        }
+        os << pid << ": " << left << setw(16) << config_.playerNames_[pid] << right;
+        if (!total.moves_) {
+            os << "    (no statistics)\n";
+            continue;
+        }
+        const double moves = total.moves_;
+        os << setw(9) << total.moves_
+           << setw(7) << setprecision(1) << total.depth_ / moves
+           << setw(13) << setprecision(0) << total.nodes_ / moves
+           << setw(13) << total.nodesPerSecond()
+           << setw(11) << setprecision(1) << total.branching()
+           << setw(14) << setprecision(3) << 1000 * total.evalSeconds_ / moves
+           << setw(12) << setprecision(1) << total.tasks_ / moves
+           << setw(9) << setprecision(3) << 1000 * total.wallSeconds_ / moves << "\n";
+    }
+}
+
+}  // namespace
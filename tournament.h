@@ -0,0 +1,59 @@
+// Tournament: play many games between the same set of players, in-process and
+// in parallel. Every game gets its own seed (consecutive from a base seed) and its
+// own board and players. The tournament tallies up wins, losses, ties, and an Elo
+// estimate for each player, and can stream per-game statistics to a CSV file, with
+// the same columns as gamestats.csv (so gamestats.R can read it).
+//
+
+#pragma once
+
+#include "config.h"
+#include "constants.h"
+#include "move.h"
+#include "search_stats.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace grandeur {
+
+class Tournament {
+  public:
+    // The outcome of a single game, mostly from the point of view of player 0:
+    struct GameStats {
+        player_id_t winner_ = 0;    // Player who won (or a larger number if tied)
+        unsigned rounds_ = 0;
+        unsigned take2_ = 0, take3_ = 0, buy_ = 0, reserve_ = 0;  // Player 0's moves
+        unsigned buyDeck_[NDECKS] = {};         // Player 0's purchases, by deck
+        unsigned nobles_[MAX_NPLAYER] = {};     // Nobles won, per player
+        points_t points_[MAX_NPLAYER] = {};     // Final points, per player
+        SearchStats search_[MAX_NPLAYER];       // Search statistics (if collected), per player
+        double seconds_ = 0;
+    };
+
+    // Take the players, no. of games, and base seed from config:
+    explicit Tournament(const Config& config);
+
+    // Play all the games. If csv isn't null, write a line per game to it as they finish:
+    void run(std::ostream* csv = nullptr);
+
+    // Print total results per player, and timings (and search statistics, if configured):
+    void report(std::ostream& os) const;
+
+    const std::vector<GameStats>& results() const { return results_; }
+
+  private:
+    // Play one game with a given seed:
+    GameStats play(uint64_t seed) const;
+
+    // Print the total search statistics per player:
+    void reportSearch(std::ostream& os) const;
+
+    const Config& config_;
+    std::vector<GameStats> results_;  // Per game, in seed order
+    double seconds_ = 0;              // Total wall-clock time
+};
+
+}  // namespace
@@ -0,0 +1,131 @@
+// Definitions for the lock-free transposition table
+//
+
+#include "transposition_table.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace grandeur {
+
+// Pack an entry's fields (other than score) into one word:
+static inline uint64_t
+packData(const TranspositionTable::Entry& entry)
+{
+    assert(entry.depth_ < 0x100 && entry.bestMove_ <= TranspositionTable::NO_MOVE);
+    return uint64_t(entry.depth_) | (uint64_t(entry.bound_) << 8) | (uint64_t(entry.bestMove_) << 16);
+}
+
+static inline uint64_t
+packScore(score_t score)
+{
+    uint64_t ret;
+    std::memcpy(&ret, &score, sizeof(ret));
+    return ret;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+TranspositionTable::TranspositionTable(unsigned sizeLog2)
+  : slots_(nullptr), mask_(sizeLog2? (size_t(1) << sizeLog2) - 1 : 0), probes_(0), hits_(0)
+{
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+TranspositionTable::~TranspositionTable()
+{
+    delete[] slots_.load();
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+TranspositionTable::Slot*
+TranspositionTable::allocate()
+{
+    auto fresh = new Slot[size()];
+    clearSlots(fresh);
+    Slot* expected = nullptr;
+    if (!slots_.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+        delete[] fresh;
+        return expected;
+    }
+    return fresh;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+bool
+TranspositionTable::probe(uint64_t key, Entry& entry) const
+{
+    if (!size()) {
+        return false;
+    }
+    probes_.fetch_add(1, std::memory_order_relaxed);
+    const auto slots = slots_.load(std::memory_order_acquire);
+    if (!slots) {
+        return false;
+    }
+
+    const auto& slot = slots[key & mask_];
+    const auto score = slot.score_.load(std::memory_order_relaxed);
+    const auto data = slot.data_.load(std::memory_order_relaxed);
+    if ((slot.check_.load(std::memory_order_relaxed) ^ score ^ data) != key) {
+        return false;
+    }
+
+    std::memcpy(&entry.score_, &score, sizeof(score));
+    entry.depth_ = data & 0xFF;
+    entry.bound_ = bound_t((data >> 8) & 0xFF);
+    entry.bestMove_ = (data >> 16) & 0xFF;
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+void
+TranspositionTable::store(uint64_t key, const Entry& entry)
+{
+    if (!size()) {
+        return;
+    }
+    auto slots = slots_.load(std::memory_order_acquire);
+    if (!slots) {
+        slots = allocate();
+    }
+
+    auto& slot = slots[key & mask_];
+    const auto score = packScore(entry.score_);
+    const auto data = packData(entry);
+    slot.check_.store(key ^ score ^ data, std::memory_order_relaxed);
+    slot.score_.store(score, std::memory_order_relaxed);
+    slot.data_.store(data, std::memory_order_relaxed);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+void
+TranspositionTable::clear()
+{
+    if (const auto slots = slots_.load(std::memory_order_acquire)) {
+        clearSlots(slots);
+    }
+    probes_ = 0;
+    hits_ = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// An empty slot only matches the key ~0, which is as unlikely as any other collision.
+void
+TranspositionTable::clearSlots(Slot* slots)
+{
+    for (size_t i = 0; i < size(); ++i) {
+        slots[i].check_.store(0, std::memory_order_relaxed);
+        slots[i].score_.store(0, std::memory_order_relaxed);
+        slots[i].data_.store(~uint64_t(0), std::memory_order_relaxed);
+    }
+}
+
+} // namespace
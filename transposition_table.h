@@ -0,0 +1,83 @@
+// TranspositionTable: a fixed-size hash table of search results, keyed by
+// Board::hash(). Different move orders often reach the same board, and this
+// table lets a search reuse the score it already computed for it.
+//
+// The table is lock-free and safe to share among threads: every slot is written
+// as three independent words, the first of which is the key XOR'ed with the other
+// two. A reader that races with a writer will find an inconsistent slot, which
+// then simply doesn't match its key (a.k.a. "lockless hashing").
+//
+// The slots are only allocated (and cleared) by the first store, so a player that
+// never stores anything, such as one that searches a single turn ahead, costs no
+// more than a pointer.
+//
+
+#pragma once
+
+#include "eval.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace grandeur {
+
+class TranspositionTable {
+  public:
+    // How a stored score relates to the real score of the board:
+    enum bound_t : uint8_t {
+        EXACT = 0,  // Score is exact
+        LOWER = 1,  // Real score is at least score (search failed high)
+        UPPER = 2   // Real score is at most score (search failed low)
+    };
+
+    static constexpr unsigned NO_MOVE = 0xFF;
+
+    struct Entry {
+        score_t score_;
+        unsigned depth_;     // Search depth that produced the score
+        bound_t bound_;
+        unsigned bestMove_;  // Index of best move in legalMoves(), or NO_MOVE
+    };
+
+    // Create a table with 2^sizeLog2 slots (or an always-empty table, if zero):
+    explicit TranspositionTable(unsigned sizeLog2);
+    ~TranspositionTable();
+
+    // Look up the entry stored for a key. Returns false if none found.
+    bool probe(uint64_t key, Entry& entry) const;
+
+    // Store an entry for a key, replacing whatever was in its slot:
+    void store(uint64_t key, const Entry& entry);
+
+    // Remove all entries and reset statistics:
+    void clear();
+
+    size_t size() const { return mask_? mask_ + 1 : 0; }
+
+    // The memory the slots take up (none before the first store):
+    size_t bytes() const { return slots_.load(std::memory_order_acquire)? size() * sizeof(Slot) : 0; }
+
+    // Statistics: how many times probe() was called, and how many found an entry.
+    uint64_t probes() const { return probes_; }
+    uint64_t hits() const { return hits_; }
+
+  private:
+    struct Slot {
+        std::atomic<uint64_t> check_;  // key ^ score_ ^ data_
+        std::atomic<uint64_t> score_;
+        std::atomic<uint64_t> data_;
+    };
+
+    // Allocate and clear the slots, unless another thread already has:
+    Slot* allocate();
+
+    // Empty every slot:
+    void clearSlots(Slot* slots);
+
+    std::atomic<Slot*> slots_;
+    size_t mask_;
+    mutable std::atomic<uint64_t> probes_;
+    mutable std::atomic<uint64_t> hits_;
+};
+
+}  // namespace
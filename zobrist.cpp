@@ -0,0 +1,10 @@
+// Definition of the global Zobrist keys, generated at compile time.
+//
+
+#include "zobrist.h"
+
+namespace grandeur {
+
+constexpr ZobristKeys g_zobrist;
+
+} // namespace
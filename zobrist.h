@@ -0,0 +1,102 @@
+// Random keys for Zobrist hashing of a Board. Every element of the board state
+// (a gem count of a color, a card on the table, a reserve, a noble, etc.) gets
+// its own 64-bit key, and a board's hash is the XOR of the keys of all its
+// elements. So the hash can be updated incrementally as the board changes, and
+// different move orders that reach the same board reach the same hash.
+//
+// The keys are generated at compile time from a fixed seed, so hashes are the
+// same across runs and threads.
+//
+
+#pragma once
+
+#include "card.h"
+#include "constants.h"
+#include "gems.h"
+#include "noble.h"
+
+#include <cassert>
+#include <cstdint>
+
+namespace grandeur {
+
+struct ZobristKeys {
+    // Upper bounds (exclusive) on the counts that can be hashed:
+    static constexpr unsigned MAX_GEM_COUNT = 16;
+    static constexpr unsigned MAX_PRESTIGE = 32;
+    static constexpr unsigned MAX_POINTS = 64;
+    static constexpr unsigned MAX_REMAINING = 64;
+    static constexpr unsigned MAX_ROUND = MAX_GAME_ROUNDS + 2;
+
+    constexpr ZobristKeys();
+
+    uint64_t tableGems_[NCOLOR][MAX_GEM_COUNT];
+    uint64_t playerGems_[MAX_NPLAYER][NCOLOR][MAX_GEM_COUNT];
+    uint64_t prestige_[MAX_NPLAYER][NCOLOR][MAX_PRESTIGE];
+    uint64_t points_[MAX_NPLAYER][MAX_POINTS];
+    uint64_t tableCards_[NCARDS];
+    uint64_t reserves_[MAX_NPLAYER][NCARDS];
+    uint64_t wildReserves_[MAX_NPLAYER][NDECKS][MAX_PLAYER_RESERVES + 1]; // By count
+    uint64_t nobles_[NNOBLES];
+    uint64_t remaining_[NDECKS][MAX_REMAINING];
+    uint64_t round_[MAX_ROUND];
+    uint64_t side_[MAX_NPLAYER];  // The player about to move
+
+  private:
+    // SplitMix64 generator step (good enough for hash keys):
+    static constexpr uint64_t next(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    template <typename T, unsigned N>
+    static constexpr void fill(T (&keys)[N], uint64_t& state)
+    {
+        for (unsigned i = 0; i < N; ++i) {
+            fill(keys[i], state);
+        }
+    }
+
+    static constexpr void fill(uint64_t& key, uint64_t& state) { key = next(state); }
+};
+
+
+constexpr ZobristKeys::ZobristKeys()
+  : tableGems_{}, playerGems_{}, prestige_{}, points_{}, tableCards_{}, reserves_{},
+    wildReserves_{}, nobles_{}, remaining_{}, round_{}, side_{}
+{
+    uint64_t state = 0x6772616e64657572ULL;
+    fill(tableGems_, state);
+    fill(playerGems_, state);
+    fill(prestige_, state);
+    fill(points_, state);
+    fill(tableCards_, state);
+    fill(reserves_, state);
+    fill(wildReserves_, state);
+    fill(nobles_, state);
+    fill(remaining_, state);
+    fill(round_, state);
+    fill(side_, state);
+}
+
+extern const ZobristKeys g_zobrist;
+
+
+// The combined key of all the colors of a gem collection:
+template <unsigned N>
+inline uint64_t
+gemsKey(const uint64_t (&keys)[NCOLOR][N], const Gems& gems)
+{
+    uint64_t ret = 0;
+    for (unsigned color = 0; color < NCOLOR; ++color) {
+        const auto count = gems.getCount(gem_color_t(color));
+        assert(count >= 0 && unsigned(count) < N);
+        ret ^= keys[color][count];
+    }
+    return ret;
+}
+
+} // namespace